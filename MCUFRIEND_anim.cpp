@@ -0,0 +1,65 @@
+#include "MCUFRIEND_anim.h"
+#include "utility/rle565.h"
+
+static uint16_t get16(const uint8_t *p)
+{
+	return (pgm_read_byte(p) << 8) | pgm_read_byte(p + 1);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return ((uint32_t)get16(p) << 16) | get16(p + 2);
+}
+
+DeltaAnimation::DeltaAnimation(const uint8_t *data) : _first(data + HEADER), _second(data + HEADER), _next(data + HEADER)
+{
+	if (pgm_read_byte(data) != 'd' || pgm_read_byte(data + 1) != '5' || pgm_read_byte(data + 2) != '6' || pgm_read_byte(data + 3) != '5')
+		return;
+	_w = get16(data + 4);
+	_h = get16(data + 6);
+	_frames = get16(data + 8);
+	_loop = (pgm_read_byte(data + 10) & LOOP) && _frames > 1;
+	_second = _first + get32(_first);
+}
+
+void DeltaAnimation::drawFrame(MCUFRIEND_kbv &tft, int16_t x, int16_t y)
+{
+	if (!_frames)
+		return;
+	const uint8_t *rec = _next, *p = rec + 6;
+	_rects = get16(rec + 4);
+	_pixels = 0;
+	for (uint16_t i = 0; i < _rects; i++, p += 8)
+	{
+		const int16_t rx = x + get16(p), ry = y + get16(p + 2), rw = get16(p + 4) & ~RLE, rh = get16(p + 6);
+		const bool rle = get16(p + 4) & RLE;
+		int32_t n = (int32_t)rw * rh;
+		_pixels += n;
+		tft.setAddrWindow(rx, ry, rx + rw - 1, ry + rh - 1);
+		if (!rle)
+		{
+			for (const uint8_t *px = p + 8; n > 0; n -= 0x4000, px += 0x8000)
+				tft.pushColors(px, (n < 0x4000) ? n : 0x4000, px == p + 8, true);
+			p += (int32_t)rw * rh * 2;
+			continue;
+		}
+		uint16_t line[LINE_PIXELS];
+		Rle565Decoder rled(p + 8, true);
+		for (bool first = true; n > 0; n -= LINE_PIXELS, first = false)
+		{
+			const int16_t k = (n < LINE_PIXELS) ? n : LINE_PIXELS;
+			rled.read(line, k);
+			tft.pushColors(line, k, first);
+		}
+		p = rled.position() - 8;
+	}
+	// frame 0, 1 .. last, then the loop delta (standing in for frame 0) and on from frame 1
+	if (_inLoop)
+		_next = _second, _frame = 1, _inLoop = false;
+	else if (_frame + 1 < _frames)
+		_next = rec + get32(rec), _frame++;
+	else if (_loop)
+		_next = rec + get32(rec), _frame = 0, _inLoop = true;
+	else
+		_next = _first, _frame = 0;
+}
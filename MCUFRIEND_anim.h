@@ -0,0 +1,45 @@
+/*
+ * Delta coded animations from PROGMEM, made by extras/tools/delta_encode.
+ *
+ * Frame 0 is stored whole; every later frame only as the rectangles that changed since the one
+ * before, so the bus traffic of a frame follows the motion in it, not the frame size.
+ * Each rectangle is one window, its pixels raw 565 (pushed straight from flash) or RLE
+ * (utility/rle565.h) when that is smaller.  A looping animation can carry one more delta, from
+ * the last frame back to frame 0, so the loop does not redraw everything.
+ *
+ * Layout, all numbers high byte first:
+ *   "d565", width, height, frames (16-bit), flags (1 = loop delta present), 0
+ *   per frame: record size in bytes (32-bit, counting these 4), rectangle count (16-bit),
+ *              then per rectangle x, y, w | 0x8000 when RLE, h (16-bit) and its pixels
+ */
+
+#ifndef MCUFRIEND_ANIM_H_
+#define MCUFRIEND_ANIM_H_
+
+#include "MCUFRIEND_kbv.h"
+
+class DeltaAnimation {
+
+	public:
+	enum { HEADER = 12, LOOP = 1, RLE = 0x8000 };
+	DeltaAnimation(const uint8_t *data);
+	bool     valid(void) const { return _frames != 0; }
+	uint16_t width(void) const { return _w; }
+	uint16_t height(void) const { return _h; }
+	uint16_t frames(void) const { return _frames; }
+	uint16_t frame(void) const { return _frame; }         // the frame drawFrame() draws next
+	void     rewind(void) { _next = _first; _frame = 0; }
+
+	// draw the next frame with its top left corner at x, y.  after the last one it starts again
+	void     drawFrame(MCUFRIEND_kbv &tft, int16_t x, int16_t y);
+	uint16_t rects(void) const { return _rects; }         // what the last frame sent
+	uint32_t pixels(void) const { return _pixels; }
+
+	protected:
+	const uint8_t *_first, *_second, *_next;
+	uint16_t _w = 0, _h = 0, _frames = 0, _frame = 0, _rects = 0;
+	uint32_t _pixels = 0;
+	bool     _loop = false, _inLoop = false;
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Draw a BMP straight from an SD File, a Stream or any other streamRead() source.
+ *
+ * Each row is pushed through one window of its own, so bottom-up files need no seeking:
+ * the rows are sent bottom first.  The image is clipped to the screen; rows below it end the
+ * read early when the file is top-down.
+ * Returns BMP_OK or one of the BMP_ERR_ codes in utility/bmp_decoder.h.
+ */
+
+#ifndef MCUFRIEND_BMP_H_
+#define MCUFRIEND_BMP_H_
+
+#include "MCUFRIEND_kbv.h"
+#include "utility/bmp_decoder.h"
+
+template <class Source>
+int8_t drawBMP(MCUFRIEND_kbv &tft, Source &src, int16_t x, int16_t y)
+{
+#if defined(__AVR__)
+	enum { CHUNK = 32 };
+#else
+	enum { CHUNK = 320 };
+#endif
+	BmpDecoder<Source> bmp(src);
+	const int8_t rc = bmp.begin();
+	if (rc != BMP_OK)
+		return rc;
+	const int16_t w = bmp.width(), h = bmp.height();
+	const int16_t c0 = (x < 0) ? -x : 0, c1 = (tft.width() - x < w) ? tft.width() - x : w;
+	uint16_t line[CHUNK];
+	for (int16_t r = 0; r < h; r++)
+	{
+		const int16_t row = bmp.bottomUp() ? y + h - 1 - r : y + r;
+		if (!bmp.bottomUp() && row >= tft.height())
+			break;
+		const bool visible = (row >= 0 && row < tft.height() && c0 < c1);
+		if (visible)
+			tft.setAddrWindow(x + c0, row, x + c1 - 1, row);
+		bool first = true;
+		for (int16_t col = 0; col < w; )
+		{
+			int16_t n = (w - col < CHUNK) ? w - col : CHUNK;
+			if (col < c0 && col + n > c0) //chunks lie wholly inside or outside the visible columns
+				n = c0 - col;
+			else if (col < c1 && col + n > c1)
+				n = c1 - col;
+			if (bmp.read(line, n) != n)
+				return BMP_ERR_READ;
+			if (visible && col >= c0 && col < c1)
+			{
+				tft.pushColors(line, n, first);
+				first = false;
+			}
+			col += n;
+		}
+	}
+	return BMP_OK;
+}
+
+#endif
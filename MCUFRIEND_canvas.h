@@ -0,0 +1,224 @@
+/*
+ * RAM canvases that are flushed to a MCUFRIEND_kbv panel.
+ *
+ * IndexedCanvas4 / IndexedCanvas8 keep 4 or 8 bits per pixel in RAM (38400 / 76800 bytes for 240x320)
+ * and expand them through a 16 / 256 entry 565 palette while streaming to the panel.
+ * Drawing colours are palette indexes.  Only the rows touched since the last flush() are sent,
+ * and changing the palette recolours the whole screen on the next flush() without redrawing.
+ * Canvas rotation is not supported: rotate the panel instead.
+ *
+ * ScaledCanvas is a GFXcanvas16 at a fraction of the panel resolution (120x160 = 38400 bytes at
+ * scale 2).  flush() upscales it on the fly: one window for the whole area, every source pixel
+ * written scale times and every row replayed scale times, in one continuous pushColors stream.
+ */
+
+#ifndef MCUFRIEND_CANVAS_H_
+#define MCUFRIEND_CANVAS_H_
+
+#include "MCUFRIEND_kbv.h"
+
+template <uint8_t BPP>
+class IndexedCanvas : public Adafruit_GFX {
+
+	public:
+	static_assert(BPP == 4 || BPP == 8, "IndexedCanvas supports 4 or 8 bits per pixel");
+	enum { COLORS = 1 << BPP, CHUNK = 32 };
+
+	// buffer must hold bufferSize(w, h) bytes.  NULL allocates it from the heap like GFXcanvas16.
+	// the dirty row bits always come from the heap.  getBuffer() is NULL when either allocation failed
+	IndexedCanvas(uint16_t w, uint16_t h, uint8_t *buffer = NULL) : Adafruit_GFX(w, h), _stride((w * BPP + 7) / 8)
+	{
+		_owned = (buffer == NULL);
+		_buffer = _owned ? (uint8_t *)malloc(bufferSize(w, h)) : buffer;
+		_dirty = (uint8_t *)malloc((h + 7) / 8);
+		if (!_buffer || !_dirty)
+		{
+			if (_owned)
+				free(_buffer);
+			free(_dirty);
+			_buffer = _dirty = NULL;
+		}
+		else
+		{
+			memset(_buffer, 0, bufferSize(w, h));
+			memset(_dirty, 0, (h + 7) / 8);
+		}
+		for (uint16_t i = 0; i < COLORS; i++)
+			_palette[i] = defaultColor(i);
+		markDirty(0, h - 1);
+	}
+	~IndexedCanvas()
+	{
+		if (_owned)
+			free(_buffer);
+		free(_dirty);
+	}
+	static constexpr uint32_t bufferSize(uint16_t w, uint16_t h) { return (uint32_t)((w * BPP + 7) / 8) * h; }
+	uint8_t *getBuffer(void) const { return _buffer; }
+
+	void     setPalette(uint8_t index, uint16_t color)
+	{
+		if (index >= COLORS)
+			return;
+		_palette[index] = color;
+		markDirty(0, HEIGHT - 1);
+	}
+	void     setPalette(const uint16_t *colors, uint16_t n = COLORS)  //at most COLORS are used
+	{
+		memcpy(_palette, colors, ((n < COLORS) ? n : (uint16_t)COLORS) * sizeof(uint16_t));
+		markDirty(0, HEIGHT - 1);
+	}
+	uint16_t getPalette(uint8_t index) const { return (index < COLORS) ? _palette[index] : 0; }
+
+	uint8_t  getPixel(int16_t x, int16_t y) const
+	{
+		if (!_buffer || x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT)
+			return 0;
+		const uint8_t *p = _buffer + (uint32_t)y * _stride;
+		if (BPP == 8)
+			return p[x];
+		return (x & 1) ? (p[x >> 1] & 0x0F) : (p[x >> 1] >> 4);
+	}
+
+	virtual void drawPixel(int16_t x, int16_t y, uint16_t color)
+	{
+		if (!_buffer || x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT)
+			return;
+		uint8_t *p = _buffer + (uint32_t)y * _stride;
+		if (BPP == 8)
+			p[x] = color;
+		else if (x & 1)
+			p[x >> 1] = (p[x >> 1] & 0xF0) | (color & 0x0F);
+		else
+			p[x >> 1] = (p[x >> 1] & 0x0F) | (color << 4);
+		markDirty(y, y);
+	}
+
+	virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+	{
+		int16_t x1 = x + w, y1 = y + h;
+		if (x < 0)
+			x = 0;
+		if (y < 0)
+			y = 0;
+		if (x1 > WIDTH)
+			x1 = WIDTH;
+		if (y1 > HEIGHT)
+			y1 = HEIGHT;
+		if (!_buffer || x >= x1 || y >= y1)
+			return;
+		markDirty(y, y1 - 1);
+		const uint8_t fill = (BPP == 8) ? color : ((color & 0x0F) * 0x11);
+		for (uint8_t *row = _buffer + (uint32_t)y * _stride; y < y1; y++, row += _stride)
+		{
+			if (BPP == 8)
+			{
+				memset(row + x, fill, x1 - x);
+				continue;
+			}
+			int16_t xs = x, xe = x1;
+			if (xs & 1) //odd start shares its byte with the left neighbour
+				row[xs >> 1] = (row[xs >> 1] & 0xF0) | (fill & 0x0F), xs++;
+			if (xe & 1) //odd end shares its byte with the right neighbour
+				xe--, row[xe >> 1] = (row[xe >> 1] & 0x0F) | (fill & 0xF0);
+			if (xe > xs)
+				memset(row + (xs >> 1), fill, (xe - xs) >> 1);
+		}
+	}
+	virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { fillRect(x, y, 1, h, color); }
+	virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { fillRect(x, y, w, 1, color); }
+	virtual void fillScreen(uint16_t color)                                     { fillRect(0, 0, WIDTH, HEIGHT, color); }
+
+	void     markDirty(int16_t y0, int16_t y1)
+	{
+		if (!_dirty)
+			return;
+		for (y0 = (y0 < 0) ? 0 : y0; y0 <= y1 && y0 < HEIGHT; y0++)
+			_dirty[y0 >> 3] |= 1 << (y0 & 7);
+	}
+	bool     isDirty(int16_t y) const { return _dirty && y >= 0 && y < HEIGHT && (_dirty[y >> 3] & (1 << (y & 7))); }
+
+	// send every run of dirty rows with one window, expanding CHUNK pixels at a time
+	void     flush(MCUFRIEND_kbv &tft, int16_t x = 0, int16_t y = 0)
+	{
+		uint16_t line[CHUNK];
+		for (int16_t r0 = 0; r0 < HEIGHT; r0++)
+		{
+			if (!isDirty(r0))
+				continue;
+			int16_t r1 = r0;
+			while (r1 + 1 < HEIGHT && isDirty(r1 + 1))
+				r1++;
+			tft.setAddrWindow(x, y + r0, x + WIDTH - 1, y + r1);
+			bool first = true;
+			for (int16_t r = r0; r <= r1; r++)
+			{
+				const uint8_t *src = _buffer + (uint32_t)r * _stride;
+				for (int16_t col = 0; col < WIDTH; col += CHUNK)
+				{
+					const int16_t n = (WIDTH - col < CHUNK) ? WIDTH - col : CHUNK;
+					expand(src, col, n, line);
+					tft.pushColors(line, n, first);
+					first = false;
+				}
+				_dirty[r >> 3] &= ~(1 << (r & 7));
+			}
+			r0 = r1;
+		}
+	}
+
+	protected:
+	void     expand(const uint8_t *src, int16_t col, int16_t n, uint16_t *dst) const
+	{
+		if (BPP == 8)
+		{
+			for (src += col; n > 0; --n)
+				*dst++ = _palette[*src++];
+			return;
+		}
+		src += col >> 1; //col is a multiple of CHUNK, so always even
+		for (; n >= 2; n -= 2)
+		{
+			const uint8_t b = *src++;
+			*dst++ = _palette[b >> 4];
+			*dst++ = _palette[b & 0x0F];
+		}
+		if (n)
+			*dst = _palette[*src >> 4];
+	}
+	static uint16_t defaultColor(uint8_t i)
+	{
+		static const uint16_t colors16[16] PROGMEM = {
+			TFT_BLACK, TFT_NAVY, TFT_DARKGREEN, TFT_DARKCYAN, TFT_MAROON, TFT_PURPLE, TFT_OLIVE, TFT_LIGHTGREY,
+			TFT_DARKGREY, TFT_BLUE, TFT_GREEN, TFT_CYAN, TFT_RED, TFT_MAGENTA, TFT_YELLOW, TFT_WHITE,
+		};
+		if (BPP == 4)
+			return pgm_read_word(&colors16[i]);
+		// RGB332 cube
+		const uint8_t r = i & 0xE0, g = (i << 3) & 0xE0, b = (i << 6) & 0xC0;
+		return ((r | r >> 3) & 0xF8) << 8 | ((g | g >> 3) & 0xFC) << 3 | (b | b >> 2 | b >> 4) >> 3;
+	}
+
+	uint8_t *_buffer;
+	uint16_t _stride;
+	bool     _owned;
+	uint8_t *_dirty;                  // a bit per row
+	uint16_t _palette[COLORS];
+};
+
+typedef IndexedCanvas<4> IndexedCanvas4;
+typedef IndexedCanvas<8> IndexedCanvas8;
+
+class ScaledCanvas : public GFXcanvas16 {
+
+	public:
+	ScaledCanvas(uint16_t w, uint16_t h, uint8_t scale) : GFXcanvas16(w, h), _scale(scale) {}
+	uint8_t  scale(void) const { return _scale; }
+
+	void     flush(MCUFRIEND_kbv &tft, int16_t x = 0, int16_t y = 0) { tft.drawRGBBitmapScaled(x, y, getBuffer(), width(), height(), _scale); }
+
+	protected:
+	uint8_t  _scale;
+};
+
+#endif
@@ -0,0 +1,300 @@
+#include "MCUFRIEND_displaylist.h"
+
+enum
+{
+	DL_RECT,
+	DL_FRAME,
+	DL_LINE,
+	DL_CIRCLE,
+	DL_FILL_CIRCLE,
+	DL_ROUND_RECT,
+	DL_FILL_ROUND_RECT,
+	DL_TRIANGLE,
+	DL_FILL_TRIANGLE,
+	DL_TEXT,
+	DL_BITMAP,
+	DL_RGB_BITMAP,
+};
+
+void WindowCanvas::setWindow(int16_t screenW, int16_t screenH, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	_width = screenW; // text wrapping and getTextBounds() see the whole screen
+	_height = screenH;
+	_wx = x, _wy = y, _ww = w, _wh = h;
+}
+
+void WindowCanvas::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+	x -= _wx;
+	y -= _wy;
+	if ((uint16_t)x < (uint16_t)_ww && (uint16_t)y < (uint16_t)_wh)
+		_buffer[y * _ww + x] = color;
+}
+
+void WindowCanvas::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	int16_t x1 = x + w - _wx, y1 = y + h - _wy;
+	x -= _wx;
+	y -= _wy;
+	if (x < 0)
+		x = 0;
+	if (y < 0)
+		y = 0;
+	if (x1 > _ww)
+		x1 = _ww;
+	if (y1 > _wh)
+		y1 = _wh;
+	for (; y < y1; y++)
+	{
+		uint16_t *p = _buffer + y * _ww + x;
+		for (int16_t n = x1 - x; n > 0; --n)
+			*p++ = color;
+	}
+}
+
+void WindowCanvas::fillScreen(uint16_t color)
+{
+	uint16_t *p = _buffer;
+	for (int32_t n = (int32_t)_ww * _wh; n > 0; --n)
+		*p++ = color;
+}
+
+DisplayItem *DisplayList::add(uint8_t type, uint16_t color, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	if (_count >= _capacity)
+	{
+		_overflow = true;
+		return NULL;
+	}
+	DisplayItem *it = &_items[_count++];
+	it->type = type;
+	it->color = it->bg = color;
+	it->x = x, it->y = y, it->w = w, it->h = h;
+	it->p[0] = x, it->p[1] = y, it->p[2] = w, it->p[3] = h;
+	return it;
+}
+
+void DisplayList::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	add(DL_RECT, color, x, y, w, h);
+}
+
+void DisplayList::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	add(DL_FRAME, color, x, y, w, h);
+}
+
+void DisplayList::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+	DisplayItem *it = add(DL_LINE, color, min(x0, x1), min(y0, y1), abs(x1 - x0) + 1, abs(y1 - y0) + 1);
+	if (it)
+		it->p[0] = x0, it->p[1] = y0, it->p[2] = x1, it->p[3] = y1;
+}
+
+void DisplayList::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+	DisplayItem *it = add(DL_CIRCLE, color, x0 - r, y0 - r, 2 * r + 1, 2 * r + 1);
+	if (it)
+		it->p[0] = x0, it->p[1] = y0, it->p[2] = r;
+}
+
+void DisplayList::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+	DisplayItem *it = add(DL_FILL_CIRCLE, color, x0 - r, y0 - r, 2 * r + 1, 2 * r + 1);
+	if (it)
+		it->p[0] = x0, it->p[1] = y0, it->p[2] = r;
+}
+
+void DisplayList::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color)
+{
+	DisplayItem *it = add(DL_ROUND_RECT, color, x, y, w, h);
+	if (it)
+		it->p[4] = r;
+}
+
+void DisplayList::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color)
+{
+	DisplayItem *it = add(DL_FILL_ROUND_RECT, color, x, y, w, h);
+	if (it)
+		it->p[4] = r;
+}
+
+static DisplayItem *addTriangle(DisplayItem *it, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+	if (it)
+	{
+		const int16_t xmin = min(x0, min(x1, x2)), ymin = min(y0, min(y1, y2));
+		it->x = xmin, it->w = max(x0, max(x1, x2)) - xmin + 1;
+		it->y = ymin, it->h = max(y0, max(y1, y2)) - ymin + 1;
+		it->p[0] = x0, it->p[1] = y0, it->p[2] = x1, it->p[3] = y1, it->p[4] = x2, it->p[5] = y2;
+	}
+	return it;
+}
+
+void DisplayList::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
+{
+	addTriangle(add(DL_TRIANGLE, color, 0, 0, 0, 0), x0, y0, x1, y1, x2, y2);
+}
+
+void DisplayList::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
+{
+	addTriangle(add(DL_FILL_TRIANGLE, color, 0, 0, 0, 0), x0, y0, x1, y1, x2, y2);
+}
+
+void DisplayList::drawText(int16_t x, int16_t y, const char *text, uint16_t color, uint16_t bg, uint8_t size, const GFXfont *font)
+{
+	DisplayItem *it = add(DL_TEXT, color, x, y, 0, 0); //bounds need the font metrics: see draw()
+	if (it)
+		it->bg = bg, it->size = size, it->data = text, it->font = font;
+}
+
+void DisplayList::drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color)
+{
+	DisplayItem *it = add(DL_BITMAP, color, x, y, w, h);
+	if (it)
+		it->size = 0, it->data = bitmap;
+}
+
+void DisplayList::drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg)
+{
+	DisplayItem *it = add(DL_BITMAP, color, x, y, w, h);
+	if (it)
+		it->size = 1, it->bg = bg, it->data = bitmap;
+}
+
+void DisplayList::drawRGBBitmap(int16_t x, int16_t y, const uint16_t *bitmap, int16_t w, int16_t h)
+{
+	DisplayItem *it = add(DL_RGB_BITMAP, 0, x, y, w, h);
+	if (it)
+		it->data = bitmap;
+}
+
+void DisplayList::draw(WindowCanvas &gfx)
+{
+	const int16_t wx = gfx.windowX(), wy = gfx.windowY(), wx1 = wx + gfx.windowW(), wy1 = wy + gfx.windowH();
+	for (uint16_t i = 0; i < _count; i++)
+	{
+		DisplayItem *it = &_items[i];
+		if (it->type == DL_TEXT)
+		{
+			gfx.setFont(it->font);
+			gfx.setTextSize(it->size);
+			if (it->w == 0)
+			{
+				uint16_t w, h;
+				gfx.getTextBounds((const char *)it->data, it->p[0], it->p[1], &it->x, &it->y, &w, &h);
+				it->w = w, it->h = h;
+			}
+		}
+		if (it->x >= wx1 || it->y >= wy1 || it->x + it->w <= wx || it->y + it->h <= wy)
+			continue;
+		const int16_t *p = it->p;
+		switch (it->type)
+		{
+		case DL_RECT:
+			gfx.fillRect(p[0], p[1], p[2], p[3], it->color);
+			break;
+		case DL_FRAME:
+			gfx.drawRect(p[0], p[1], p[2], p[3], it->color);
+			break;
+		case DL_LINE:
+			gfx.drawLine(p[0], p[1], p[2], p[3], it->color);
+			break;
+		case DL_CIRCLE:
+			gfx.drawCircle(p[0], p[1], p[2], it->color);
+			break;
+		case DL_FILL_CIRCLE:
+			gfx.fillCircle(p[0], p[1], p[2], it->color);
+			break;
+		case DL_ROUND_RECT:
+			gfx.drawRoundRect(p[0], p[1], p[2], p[3], p[4], it->color);
+			break;
+		case DL_FILL_ROUND_RECT:
+			gfx.fillRoundRect(p[0], p[1], p[2], p[3], p[4], it->color);
+			break;
+		case DL_TRIANGLE:
+			gfx.drawTriangle(p[0], p[1], p[2], p[3], p[4], p[5], it->color);
+			break;
+		case DL_FILL_TRIANGLE:
+			gfx.fillTriangle(p[0], p[1], p[2], p[3], p[4], p[5], it->color);
+			break;
+		case DL_TEXT:
+			gfx.setTextColor(it->color, it->bg);
+			gfx.setCursor(p[0], p[1]);
+			gfx.print((const char *)it->data);
+			break;
+		case DL_BITMAP:
+			if (it->size)
+				gfx.drawBitmap(p[0], p[1], (const uint8_t *)it->data, p[2], p[3], it->color, it->bg);
+			else
+				gfx.drawBitmap(p[0], p[1], (const uint8_t *)it->data, p[2], p[3], it->color);
+			break;
+		case DL_RGB_BITMAP:
+			gfx.drawRGBBitmap(p[0], p[1], (const uint16_t *)it->data, p[2], p[3]);
+			break;
+		}
+	}
+}
+
+void BandRenderer::render(MCUFRIEND_kbv &tft, DisplayList &list, uint16_t background)
+{
+	const int16_t w = tft.width(), h = tft.height();
+	const int16_t chunk = 32767 / w * w; //pushColors() counts in int16_t
+	for (int16_t y = 0; y < h; y += _rows)
+	{
+		const int16_t rows = (h - y < _rows) ? h - y : _rows;
+		_canvas.setWindow(w, h, 0, y, w, rows);
+		_canvas.fillScreen(background);
+		list.draw(_canvas);
+		tft.setAddrWindow(0, y, w - 1, y + rows - 1);
+		uint16_t *p = _canvas.getBuffer();
+		bool first = true;
+		for (int32_t n = (int32_t)w * rows; n > 0; n -= chunk, p += chunk, first = false)
+			tft.pushColors(p, (n < chunk) ? n : chunk, first);
+	}
+}
+
+// FNV-1a over the 16-bit pixels
+static uint32_t hashPixels(const uint16_t *p, int16_t n)
+{
+	uint32_t hash = 2166136261UL;
+	for (; n > 0; --n)
+		hash = (hash ^ *p++) * 16777619UL;
+	return hash;
+}
+
+void TileRenderer::render(MCUFRIEND_kbv &tft, DisplayList &list, uint16_t background)
+{
+	const int16_t w = tft.width(), h = tft.height();
+	if (w != _w || h != _h) //rotated: the old hashes describe other tiles
+		_w = w, _h = h, _valid = false;
+	_stats.pushed = _stats.skipped = 0;
+	uint16_t tile = 0;
+	for (int16_t y = 0; y < h; y += _size)
+	{
+		const int16_t th = (h - y < _size) ? h - y : _size;
+		for (int16_t x = 0; x < w; x += _size, tile++)
+		{
+			const int16_t tw = (w - x < _size) ? w - x : _size;
+			_canvas.setWindow(w, h, x, y, tw, th);
+			_canvas.fillScreen(background);
+			list.draw(_canvas);
+			const uint32_t hash = hashPixels(_canvas.getBuffer(), tw * th);
+			if (tile < _count)
+			{
+				if (_valid && _hashes[tile] == hash)
+				{
+					_stats.skipped++;
+					continue;
+				}
+				_hashes[tile] = hash;
+			}
+			tft.setAddrWindow(x, y, x + tw - 1, y + th - 1);
+			tft.pushColors(_canvas.getBuffer(), tw * th, true);
+			_stats.pushed++;
+		}
+	}
+	_valid = true;
+	_stats.totalPushed += _stats.pushed;
+	_stats.totalSkipped += _stats.skipped;
+}
@@ -0,0 +1,133 @@
+/*
+ * Retained mode rendering for boards without room for a framebuffer.
+ *
+ * A DisplayList records the primitives of a frame.  BandRenderer then rasterises the screen
+ * in horizontal bands of a few lines into a small 565 buffer (width * rows * 2 bytes) and sends
+ * each band with one window and one pushColors, so every panel pixel is written exactly once.
+ * TileRenderer rasterises the list one tile at a time and only sends the tiles whose hash changed
+ * since the previous frame.
+ * Text and bitmaps are recorded by pointer: the caller keeps them alive until the frame is rendered.
+ */
+
+#ifndef MCUFRIEND_DISPLAYLIST_H_
+#define MCUFRIEND_DISPLAYLIST_H_
+
+#include "MCUFRIEND_kbv.h"
+
+// Adafruit_GFX target that covers the whole screen but only stores a w x h window of it.
+// Everything outside the window is clipped.
+class WindowCanvas : public Adafruit_GFX {
+
+	public:
+	WindowCanvas(uint16_t *buffer) : Adafruit_GFX(240, 320), _buffer(buffer) {}
+	void     setWindow(int16_t screenW, int16_t screenH, int16_t x, int16_t y, int16_t w, int16_t h);
+	uint16_t *getBuffer(void) const { return _buffer; }
+	int16_t  windowX(void) const { return _wx; }
+	int16_t  windowY(void) const { return _wy; }
+	int16_t  windowW(void) const { return _ww; }
+	int16_t  windowH(void) const { return _wh; }
+
+	virtual void drawPixel(int16_t x, int16_t y, uint16_t color);
+	virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+	virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { fillRect(x, y, 1, h, color); }
+	virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { fillRect(x, y, w, 1, color); }
+	virtual void fillScreen(uint16_t color);
+
+	protected:
+	uint16_t *_buffer;
+	int16_t  _wx = 0, _wy = 0, _ww = 0, _wh = 0;
+};
+
+struct DisplayItem {
+	uint8_t  type;
+	uint8_t  size;              // text size, opaque flag for 1-bpp bitmaps
+	uint16_t color, bg;
+	int16_t  x, y, w, h;        // bounding box
+	int16_t  p[6];              // primitive arguments
+	const void *data;           // text or PROGMEM bitmap
+	const GFXfont *font;
+};
+
+class DisplayList {
+
+	public:
+	DisplayList(DisplayItem *items, uint16_t capacity) : _items(items), _capacity(capacity) {}
+	void     clear(void) { _count = 0; _overflow = false; }
+	uint16_t count(void) const { return _count; }
+	bool     overflow(void) const { return _overflow; }  // something was dropped since clear()
+
+	void     fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+	void     drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+	void     drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { fillRect(x, y, w, 1, color); }
+	void     drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { fillRect(x, y, 1, h, color); }
+	void     drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+	void     drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+	void     fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+	void     drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+	void     fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+	void     drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+	void     fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+	// bg == color draws transparent text, like Adafruit_GFX::setTextColor(color)
+	void     drawText(int16_t x, int16_t y, const char *text, uint16_t color, uint16_t bg, uint8_t size = 1, const GFXfont *font = NULL);
+	void     drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
+	void     drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg);
+	void     drawRGBBitmap(int16_t x, int16_t y, const uint16_t *bitmap, int16_t w, int16_t h);
+
+	// replay every item that touches the window of gfx
+	void     draw(WindowCanvas &gfx);
+
+	protected:
+	DisplayItem *add(uint8_t type, uint16_t color, int16_t x, int16_t y, int16_t w, int16_t h);
+
+	DisplayItem *_items;
+	uint16_t _capacity, _count = 0;
+	bool     _overflow = false;
+};
+
+template <uint16_t N>
+class StaticDisplayList : public DisplayList {
+	public:
+	StaticDisplayList() : DisplayList(_storage, N) {}
+	private:
+	DisplayItem _storage[N];
+};
+
+class BandRenderer {
+
+	public:
+	// buffer holds screen width * rows pixels
+	BandRenderer(uint16_t *buffer, int16_t rows) : _canvas(buffer), _rows(rows) {}
+	void     render(MCUFRIEND_kbv &tft, DisplayList &list, uint16_t background);
+
+	protected:
+	WindowCanvas _canvas;
+	int16_t  _rows;
+};
+
+// buffer holds size * size pixels, hashes holds tileCount(width, height, size) entries
+class TileRenderer {
+
+	public:
+	struct Stats {
+		uint16_t pushed, skipped;       // last frame
+		uint32_t totalPushed, totalSkipped;
+	};
+	TileRenderer(uint16_t *buffer, uint8_t size, uint32_t *hashes, uint16_t count)
+		: _canvas(buffer), _size(size), _hashes(hashes), _count(count) {}
+	static constexpr uint16_t tileCount(int16_t w, int16_t h, uint8_t size) { return ((w + size - 1) / size) * ((h + size - 1) / size); }
+	void     render(MCUFRIEND_kbv &tft, DisplayList &list, uint16_t background);
+	void     invalidate(void) { _valid = false; }   // push every tile on the next frame
+	const Stats &stats(void) const { return _stats; }
+	void     resetStats(void) { memset(&_stats, 0, sizeof(_stats)); }
+
+	protected:
+	WindowCanvas _canvas;
+	uint8_t  _size;
+	uint32_t *_hashes;
+	uint16_t _count;
+	int16_t  _w = 0, _h = 0;
+	bool     _valid = false;
+	Stats    _stats = {};
+};
+
+#endif
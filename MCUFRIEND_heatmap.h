@@ -0,0 +1,133 @@
+/*
+ * Bilinear upscaling of low resolution sensor grids (thermal cameras, ToF arrays) to a panel area.
+ *
+ * The grid is float or int16_t, row major.  setRange() maps grid values to a 256 entry 565
+ * colormap; values outside the range clamp to its ends.  draw() opens one window for the part of
+ * the area on the screen and produces it one output row at a time: the two grid rows around it
+ * are blended into a column of 8.8 fixed point levels, which is then stepped across horizontally.
+ * RAM: the level column (2 bytes per grid column) and a line buffer.  Grid corners land on
+ * the area corners.
+ */
+
+#ifndef MCUFRIEND_HEATMAP_H_
+#define MCUFRIEND_HEATMAP_H_
+
+#include "MCUFRIEND_kbv.h"
+
+class Heatmap {
+
+	public:
+	enum { MAX_COLUMNS = 128 };
+#if defined(__AVR__)
+	enum { CHUNK = 32 };
+#else
+	enum { CHUNK = 320 };
+#endif
+	// colormap stops, evenly spaced, for makeColormap()
+	static constexpr uint32_t IRON[] = { 0x000000, 0x20008C, 0x8C0096, 0xE63C00, 0xFFB400, 0xFFFFFF };
+	static constexpr uint32_t RAINBOW[] = { 0x0000FF, 0x00FFFF, 0x00FF00, 0xFFFF00, 0xFF0000 };
+
+	Heatmap(uint16_t *colormap) : _map(colormap) { setRange(0, 255); }  // 256 entries in RAM
+
+	// fill a 256 entry colormap from n >= 2 0xRRGGBB stops
+	static void makeColormap(uint16_t *map, const uint32_t *stops, uint8_t n)
+	{
+		for (int16_t i = 0; i < 256; i++)
+		{
+			const int32_t pos = (int32_t)i * (n - 1) * 256 / 255; //8.8 position among the stops
+			const uint8_t s = (pos >> 8 < n - 1) ? pos >> 8 : n - 2;
+			const int32_t t = pos - ((int32_t)s << 8);
+			uint8_t c[3];
+			for (uint8_t k = 0; k < 3; k++)
+			{
+				const int32_t a = (stops[s] >> (16 - 8 * k)) & 0xFF, b = (stops[s + 1] >> (16 - 8 * k)) & 0xFF;
+				c[k] = a + (((b - a) * t) >> 8);
+			}
+			map[i] = ((c[0] & 0xF8) << 8) | ((c[1] & 0xFC) << 3) | (c[2] >> 3);
+		}
+	}
+
+	void     setRange(float lo, float hi)
+	{
+		_lo = lo;
+		_scale = 65280.0f / ((hi - lo > 0) ? hi - lo : 1);  //an empty or reversed range spans 1, like the integer one
+		_ilo = lo;
+		_irange = (hi - lo >= 1) ? (int32_t)(hi - lo) : 1;
+		_iscale = (65280L << 8) / _irange;
+	}
+
+	// clipped to the screen.  a grid wider than MAX_COLUMNS is not drawn
+	template <class T>
+	void     draw(MCUFRIEND_kbv &tft, const T *grid, int16_t cols, int16_t rows, int16_t x, int16_t y, int16_t w, int16_t h)
+	{
+		if (cols < 1 || cols > MAX_COLUMNS || rows < 1 || w < 1 || h < 1)
+			return;
+		uint16_t line[CHUNK];
+		uint16_t level[MAX_COLUMNS];
+		// grid positions in 16.16 step by a quotient and a remainder, so the last pixel lands exactly on the last cell
+		const int32_t spanX = (w > 1) ? w - 1 : 1, spanY = (h > 1) ? h - 1 : 1;
+		const uint32_t dx = ((uint32_t)(cols - 1) << 16) / spanX, rx = ((uint32_t)(cols - 1) << 16) % spanX;
+		const uint32_t dy = ((uint32_t)(rows - 1) << 16) / spanY, ry = ((uint32_t)(rows - 1) << 16) % spanY;
+		const int16_t c0 = (x < 0) ? -x : 0, c1 = (tft.width() - x < w) ? tft.width() - x : w;
+		const int16_t r0 = (y < 0) ? -y : 0, r1 = (tft.height() - y < h) ? tft.height() - y : h;
+		if (c0 >= c1 || r0 >= r1)
+			return;
+		// the steps up to the first visible row and column
+		const uint32_t fx0 = c0 * dx + (uint32_t)c0 * rx / spanX, ex0 = (uint32_t)c0 * rx % spanX;
+		uint32_t fy = r0 * dy + (uint32_t)r0 * ry / spanY, ey = (uint32_t)r0 * ry % spanY;
+		tft.setAddrWindow(x + c0, y + r0, x + c1 - 1, y + r1 - 1);
+		bool first = true;
+		for (int16_t r = r0; r < r1; r++)
+		{
+			const int16_t g = fy >> 16;
+			const T *a = grid + (int32_t)g * cols, *b = (g + 1 < rows) ? a + cols : a;
+			const int32_t ty = (fy >> 4) & 0x0FFF;
+			for (int16_t j = 0; j < cols; j++)
+			{
+				const int32_t q = toLevel(a[j]);
+				level[j] = q + (((toLevel(b[j]) - q) * ty + 2048) >> 12);
+			}
+			uint32_t fx = fx0, ex = ex0;
+			for (int16_t i = c0; i < c1; i += CHUNK)
+			{
+				const int16_t n = (c1 - i < CHUNK) ? c1 - i : CHUNK;
+				for (int16_t k = 0; k < n; k++)
+				{
+					const int16_t j = fx >> 16;
+					const int32_t q = level[j], q1 = (j + 1 < cols) ? level[j + 1] : q;
+					line[k] = _map[(q + (((q1 - q) * (int32_t)((fx >> 4) & 0x0FFF)) >> 12) + 128) >> 8];
+					fx += dx;
+					if ((ex += rx) >= (uint32_t)spanX)
+						ex -= spanX, fx++;
+				}
+				tft.pushColors(line, n, first);
+				first = false;
+			}
+			fy += dy;
+			if ((ey += ry) >= (uint32_t)spanY)
+				ey -= spanY, fy++;
+		}
+	}
+
+	protected:
+	int32_t  toLevel(float v) const
+	{
+		const float q = (v - _lo) * _scale;
+		return (q <= 0) ? 0 : (q >= 65280.0f) ? 65280 : (int32_t)q;
+	}
+	int32_t  toLevel(int16_t v) const
+	{
+		int32_t d = (int32_t)v - _ilo;
+		if (d < 0)
+			d = 0;
+		if (d > _irange)
+			d = _irange;
+		return (d * _iscale) >> 8;
+	}
+
+	uint16_t *_map;
+	float    _lo, _scale;
+	int32_t  _ilo, _irange, _iscale;
+};
+
+#endif
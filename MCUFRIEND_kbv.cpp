@@ -1,5 +1,8 @@
 #include "MCUFRIEND_kbv.h"
 #include "utility/mcufriend_shield.h"
+#include "utility/rle565.h"
+#include "utility/qoi565.h"
+#include "utility/blend565.h"
 
 #define MIPI_DCS_REV1 (1 << 0)
 #define AUTO_READINC (1 << 1)
@@ -159,10 +162,83 @@ uint16_t MCUFRIEND_kbv::readID(void)
 	return ret;
 }
 
+// one 18-bit pixel is three bytes with the colour in the top 6 bits of each
+static inline uint16_t read565(void)
+{
+	uint8_t r, g, b;
+	READ_8(r);
+	READ_8(g);
+	READ_8(b);
+	if constexpr (_lcd_capable & READ_BGR)
+		std::swap(r, b);
+	return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+// RAMRD starts at the window origin, RAMRD continue (0x3E) resumes after the last pixel read.
+// Both need a dummy read.  The bus is turned around once per call, not per pixel.
+void MCUFRIEND_kbv::readColors(uint16_t *block, int16_t n, bool first)
+{
+	uint8_t dummy;
+	CS_ACTIVE;
+	WriteCmd(first ? 0x2E : 0x3E);
+	setReadDir();
+	READ_8(dummy);
+	(void)dummy;
+	if constexpr (_lcd_capable & READ_24BITS)
+	{
+		for (; n >= 4; n -= 4, block += 4)
+		{
+			block[0] = read565();
+			block[1] = read565();
+			block[2] = read565();
+			block[3] = read565();
+		}
+		for (; n > 0; --n)
+			*block++ = read565();
+	}
+	else
+	{
+		for (; n > 0; --n)
+		{
+			uint16_t ret;
+			READ_16(ret);
+			if constexpr (_lcd_capable & READ_LOWHIGH)
+				ret = (ret >> 8) | (ret << 8);
+			if constexpr (_lcd_capable & READ_BGR)
+				ret = (ret & 0x07E0) | (ret >> 11) | (ret << 11);
+			*block++ = ret;
+		}
+	}
+	RD_IDLE;
+	CS_IDLE;
+	setWriteDir();
+}
+
+void MCUFRIEND_kbv::readGRAM(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t *buffer, int16_t size, ReadSink sink, void *ctx)
+{
+	const int16_t chunk = (size >= w) ? size / w * w : size;
+	bool first = true;
+	setAddrWindow(x, y, x + w - 1, y + h - 1);
+	for (int32_t n = (int32_t)w * h; n > 0; n -= chunk, first = false)
+	{
+		const int16_t len = (n < chunk) ? n : chunk;
+		readColors(buffer, len, first);
+		sink(buffer, len, ctx);
+	}
+}
+
 // independent cursor and window registers.   S6D0154, ST7781 increments.  ILI92320/5 do not.
 int16_t MCUFRIEND_kbv::readGRAM(int16_t x, int16_t y, uint16_t *block, int16_t w, int16_t h)
 {
-	uint16_t ret, dummy, _MR = _MW;
+	if constexpr ((_lcd_capable & (MIPI_DCS_REV1 | AUTO_READINC)) == (MIPI_DCS_REV1 | AUTO_READINC))
+	{
+		bool first = true;
+		setAddrWindow(x, y, x + w - 1, y + h - 1);
+		for (int32_t n = (int32_t)w * h; n > 0; n -= 0x7FFF, block += 0x7FFF, first = false)
+			readColors(block, (n < 0x7FFF) ? n : 0x7FFF, first);
+		return 0;
+	}
+	uint16_t ret, dummy, _MR = (_lcd_capable & MIPI_DCS_REV1) ? 0x2E : _MW;
 	int16_t n = w * h, row = 0, col = 0;
 	uint8_t r, g, b;
 
@@ -479,6 +555,896 @@ void MCUFRIEND_kbv::vertScroll(int16_t top, int16_t scrollines, int16_t offset)
 	WriteCmdData(0x6A, vsp);				 //VL#
 }
 
+// Each line is read back into a buffer and written to its destination.
+// Rows and chunks are visited in the order that never overwrites source pixels not yet copied.
+void MCUFRIEND_kbv::copyRect(int16_t srcX, int16_t srcY, int16_t w, int16_t h, int16_t dstX, int16_t dstY)
+{
+	uint16_t line[LINE_PIXELS];
+	const bool bottomUp = dstY > srcY;
+	const bool rightToLeft = dstY == srcY && dstX > srcX;
+	if (dstX == srcX && dstY == srcY)
+		return;
+	// the part of the rectangle where both source and destination are on the screen
+	int16_t c0 = 0, c1 = w, r0 = 0, r1 = h;
+	if (c0 < -srcX)
+		c0 = -srcX;
+	if (c0 < -dstX)
+		c0 = -dstX;
+	if (c1 > width() - srcX)
+		c1 = width() - srcX;
+	if (c1 > width() - dstX)
+		c1 = width() - dstX;
+	if (r0 < -srcY)
+		r0 = -srcY;
+	if (r0 < -dstY)
+		r0 = -dstY;
+	if (r1 > height() - srcY)
+		r1 = height() - srcY;
+	if (r1 > height() - dstY)
+		r1 = height() - dstY;
+	if (c0 >= c1 || r0 >= r1)
+		return;
+	for (int16_t i = r0; i < r1; i++)
+	{
+		const int16_t row = bottomUp ? r1 - 1 - (i - r0) : i;
+		for (int16_t j = c0; j < c1; j += LINE_PIXELS)
+		{
+			const int16_t n = (c1 - j < LINE_PIXELS) ? c1 - j : LINE_PIXELS;
+			const int16_t col = rightToLeft ? c1 - (j - c0) - n : j;
+			readGRAM(srcX + col, srcY + row, line, n, 1);
+			setAddrWindow(dstX + col, dstY + row, dstX + col + n - 1, dstY + row);
+			pushColors(line, n, true);
+		}
+	}
+}
+
+static void encodeChunk(const uint16_t *block, int16_t n, void *ctx)
+{
+	((Rle565Encoder *)ctx)->push(block, n);
+}
+
+size_t MCUFRIEND_kbv::saveRegion(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t *buf, size_t size)
+{
+	uint16_t line[LINE_PIXELS];
+	Rle565Encoder rle(buf, size);
+	readGRAM(x, y, w, h, line, LINE_PIXELS, encodeChunk, &rle);
+	return rle.finish();
+}
+
+void MCUFRIEND_kbv::restoreRegion(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t *buf)
+{
+	uint16_t line[LINE_PIXELS];
+	Rle565Decoder rle(buf, false);
+	bool first = true;
+	setAddrWindow(x, y, x + w - 1, y + h - 1);
+	for (int32_t n = (int32_t)w * h; n > 0; n -= LINE_PIXELS, first = false)
+	{
+		const int16_t len = (n < LINE_PIXELS) ? n : LINE_PIXELS;
+		rle.read(line, len);
+		pushColors(line, len, first);
+	}
+}
+
+// clipped to the screen first: neither the providers nor fillRect() take rectangles off the top or left edge
+void MCUFRIEND_kbv::eraseRect(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	if (x < 0)
+		w += x, x = 0;
+	if (y < 0)
+		h += y, y = 0;
+	if (w > width() - x)
+		w = width() - x;
+	if (h > height() - y)
+		h = height() - y;
+	if (w <= 0 || h <= 0)
+		return;
+	if (_background)
+		_background->erase(*this, x, y, w, h);
+	else
+		fillRect(x, y, w, h, TFT_BLACK);
+}
+
+void MCUFRIEND_kbv::eraseText(int16_t x, int16_t y, const char *text)
+{
+	int16_t x1, y1;
+	uint16_t w, h;
+	getTextBounds(text, x, y, &x1, &y1, &w, &h);
+	eraseRect(x1, y1, w, h);
+}
+
+// rows of the image go straight from flash to the bus, one window for the rectangle
+void ImageBackground::erase(MCUFRIEND_kbv &tft, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	const uint16_t *row = _image + (int32_t)(y - _y) * _w + (x - _x);
+	tft.setAddrWindow(x, y, x + w - 1, y + h - 1);
+	for (int16_t i = 0; i < h; i++, row += _w)
+		tft.pushColors((const uint8_t *)row, w, i == 0);
+}
+
+// a modulo that stays positive left of and above the origin
+static int16_t wrap(int16_t v, int16_t m)
+{
+	v %= m;
+	return (v < 0) ? v + m : v;
+}
+
+void TiledBackground::erase(MCUFRIEND_kbv &tft, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	bool first = true;
+	tft.setAddrWindow(x, y, x + w - 1, y + h - 1);
+	for (int16_t i = 0; i < h; i++)
+	{
+		const uint16_t *row = _tile + wrap(y + i, _h) * _w;
+		for (int16_t col = wrap(x, _w), n = w; n > 0; col = 0)
+		{
+			const int16_t len = (_w - col < n) ? _w - col : n;
+			tft.pushColors((const uint8_t *)(row + col), len, first);
+			first = false;
+			n -= len;
+		}
+	}
+}
+
+uint16_t TiledBackground::pixel(int16_t x, int16_t y)
+{
+	return pgm_read_word(_tile + wrap(y, _h) * _w + wrap(x, _w));
+}
+
+void Brush::operator()(int16_t x, int16_t y, uint16_t *dst, int16_t n)
+{
+	const int16_t row = wrap(y, _h);
+	if (row != _row)
+	{
+		expand(row, _line);
+		_row = row;
+	}
+	for (int16_t col = wrap(x, _w); n > 0; --n)
+	{
+		*dst++ = _line[col];
+		if (++col == _w)
+			col = 0;
+	}
+}
+
+static const uint8_t patterns[][8] PROGMEM = {
+	{ 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00 },  //HORIZONTAL
+	{ 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88 },  //VERTICAL
+	{ 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 },  //DIAGONAL
+	{ 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 },  //BACK_DIAGONAL
+	{ 0xFF, 0x88, 0x88, 0x88, 0xFF, 0x88, 0x88, 0x88 },  //CROSS
+	{ 0x81, 0x42, 0x24, 0x18, 0x18, 0x24, 0x42, 0x81 },  //DIAGONAL_CROSS
+	{ 0x80, 0x00, 0x08, 0x00, 0x80, 0x00, 0x08, 0x00 },  //DOTS
+	{ 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55 },  //CHECKER
+};
+
+PatternBrush::PatternBrush(uint8_t style, uint16_t fg, uint16_t bg) : Brush(8, 8), _fg(fg), _bg(bg)
+{
+	_bits = patterns[(style < sizeof(patterns) / 8) ? style : 0];
+}
+
+void PatternBrush::expand(int16_t row, uint16_t *dst)
+{
+	const uint8_t *src = _bits + row * ((_stride + 7) / 8);
+	uint8_t b = 0;
+	for (int16_t i = 0; i < _w; i++, b <<= 1)
+	{
+		if ((i & 7) == 0)
+			b = pgm_read_byte(src++);
+		*dst++ = (b & 0x80) ? _fg : _bg;
+	}
+}
+
+void TileBrush::expand(int16_t row, uint16_t *dst)
+{
+	const uint16_t *src = _tile + (int32_t)row * _stride;
+	for (int16_t i = 0; i < _w; i++)
+		*dst++ = pgm_read_word(src++);
+}
+
+// the rows an Adafruit_GFX circle of radius r covers in column c of a quadrant.  the shape is
+// symmetric, so it is also the half width of row c
+static int16_t circleExtent(int16_t r, int16_t c)
+{
+	if (c == 0)
+		return r;
+	int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r, px = x, py = y, e = -1;
+	while (x < y && !(x >= c && y < c))
+	{
+		if (f >= 0)
+		{
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
+		if (x == c && x <= y && y > e)
+			e = y;
+		if (y != py)
+		{
+			if (py == c && px > e)
+				e = px;
+			py = y;
+		}
+		px = x;
+	}
+	return e;
+}
+
+// circleExtent(r, 0 .. r) for the last few radii drawn, so repeated widgets skip the circle maths.
+// bigger radii are worked out row by row
+#if defined(__AVR__)
+enum { SPAN_SLOTS = 1, SPAN_RADIUS = 47 };
+#else
+enum { SPAN_SLOTS = 4, SPAN_RADIUS = 255 };
+#endif
+static struct {
+	int16_t  r1;                     // radius + 1, 0 when empty
+	uint8_t  ext[SPAN_RADIUS + 1];
+} spanCache[SPAN_SLOTS];
+static uint8_t spanNext;
+
+class CircleSpans {
+	public:
+	CircleSpans(int16_t r) : _r(r), _ext(NULL)
+	{
+		if (r > SPAN_RADIUS)
+			return;
+		for (uint8_t i = 0; i < SPAN_SLOTS; i++)
+			if (spanCache[i].r1 == r + 1)
+			{
+				_ext = spanCache[i].ext;
+				return;
+			}
+		spanCache[spanNext].r1 = r + 1;
+		_ext = spanCache[spanNext].ext;
+		spanNext = (spanNext + 1) % SPAN_SLOTS;
+		// circleExtent() for every column in one pass
+		uint8_t *e = _ext;
+		memset(e, 0, r + 1);
+		e[0] = r;
+		int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r, px = x, py = y;
+		while (x < y)
+		{
+			if (f >= 0)
+			{
+				y--;
+				ddF_y += 2;
+				f += ddF_y;
+			}
+			x++;
+			ddF_x += 2;
+			f += ddF_x;
+			if (x <= y && y > e[x])
+				e[x] = y;
+			if (y != py)
+			{
+				if (px > e[py])
+					e[py] = px;
+				py = y;
+			}
+			px = x;
+		}
+	}
+	int16_t  operator[](int16_t c) const { return _ext ? _ext[c] : circleExtent(_r, c); }
+	protected:
+	int16_t  _r;
+	uint8_t *_ext;
+};
+
+// rows of spans in, rectangles out: rows in a row with the same columns share one window
+template <class Fill>
+class SpanMerger {
+	public:
+	SpanMerger(Fill &fill) : _fill(fill) {}
+	~SpanMerger() { flush(); }
+	void     add(int16_t y, int16_t x0, int16_t x1, int16_t rows = 1)
+	{
+		if (rows <= 0 || x1 < x0)
+			return;
+		if (_h && y == _y + _h && x0 == _x0 && x1 == _x1)
+		{
+			_h += rows;
+			return;
+		}
+		flush();
+		_y = y, _x0 = x0, _x1 = x1, _h = rows;
+	}
+	void     flush(void)
+	{
+		if (_h)
+			_fill(_x0, _y, _x1 - _x0 + 1, _h);
+		_h = 0;
+	}
+	protected:
+	Fill    &_fill;
+	int16_t  _y = 0, _x0 = 0, _x1 = 0, _h = 0;
+};
+
+template <class Fill>
+static void roundRectSpans(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, Fill fill)
+{
+	const int16_t most = ((w < h) ? w : h) / 2;
+	if (r > most)
+		r = most;
+	if (r < 0)
+		r = 0;
+	CircleSpans ext(r);
+	SpanMerger<Fill> spans(fill);
+	for (int16_t dy = r; dy > 0; dy--)
+		spans.add(y + r - dy, x + r - ext[dy], x + w - 1 - r + ext[dy]);
+	spans.add(y + r, x, x + w - 1, h - 2 * r);
+	for (int16_t dy = 1; dy <= r; dy++)
+		spans.add(y + h - 1 - r + dy, x + r - ext[dy], x + w - 1 - r + ext[dy]);
+}
+
+// fillRect() does not clip the top and left edges
+static void fillClipped(MCUFRIEND_kbv &tft, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	const int16_t x0 = (x < 0) ? 0 : x, x1 = (x + w > tft.width()) ? tft.width() : x + w;
+	const int16_t y0 = (y < 0) ? 0 : y, y1 = (y + h > tft.height()) ? tft.height() : y + h;
+	if (x0 < x1 && y0 < y1)
+		tft.fillRect(x0, y0, x1 - x0, y1 - y0, color);
+}
+
+void MCUFRIEND_kbv::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, Brush &brush)
+{
+	roundRectSpans(x, y, w, h, r, [&](int16_t x, int16_t y, int16_t w, int16_t h) { fillRectShader(x, y, w, h, brush); });
+}
+
+void MCUFRIEND_kbv::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color)
+{
+	roundRectSpans(x, y, w, h, r, [&](int16_t x, int16_t y, int16_t w, int16_t h) { fillClipped(*this, x, y, w, h, color); });
+}
+
+void MCUFRIEND_kbv::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+	if (r < 0)
+		return;
+	auto fill = [&](int16_t x, int16_t y, int16_t w, int16_t h) { fillClipped(*this, x, y, w, h, color); };
+	CircleSpans ext(r);
+	SpanMerger<decltype(fill)> spans(fill);
+	for (int16_t dy = -r; dy <= r; dy++)
+	{
+		const int16_t half = ext[(dy < 0) ? -dy : dy];
+		spans.add(y0 + dy, x0 - half, x0 + half);
+	}
+}
+
+// Adafruit_GFX's edge walk, so the pixels are the same
+void MCUFRIEND_kbv::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
+{
+	auto fill = [&](int16_t x, int16_t y, int16_t w, int16_t h) { fillClipped(*this, x, y, w, h, color); };
+	SpanMerger<decltype(fill)> spans(fill);
+	if (y0 > y1)
+		std::swap(y0, y1), std::swap(x0, x1);
+	if (y1 > y2)
+		std::swap(y2, y1), std::swap(x2, x1);
+	if (y0 > y1)
+		std::swap(y0, y1), std::swap(x0, x1);
+	if (y0 == y2)
+	{
+		int16_t a = x0, b = x0;
+		if (x1 < a)
+			a = x1;
+		else if (x1 > b)
+			b = x1;
+		if (x2 < a)
+			a = x2;
+		else if (x2 > b)
+			b = x2;
+		spans.add(y0, a, b);
+		return;
+	}
+	const int16_t dx01 = x1 - x0, dy01 = y1 - y0, dx02 = x2 - x0, dy02 = y2 - y0, dx12 = x2 - x1, dy12 = y2 - y1;
+	int32_t sa = 0, sb = 0;
+	// the upper part ends on y1 - 1, or on y1 when the lower part is flat
+	const int16_t last = (y1 == y2) ? y1 : y1 - 1;
+	int16_t y = y0;
+	for (; y <= last; y++)
+	{
+		int16_t a = x0 + sa / dy01, b = x0 + sb / dy02;
+		sa += dx01;
+		sb += dx02;
+		if (a > b)
+			std::swap(a, b);
+		spans.add(y, a, b);
+	}
+	sa = (int32_t)dx12 * (y - y1);
+	sb = (int32_t)dx02 * (y - y0);
+	for (; y <= y2; y++)
+	{
+		int16_t a = x1 + sa / dy12, b = x0 + sb / dy02;
+		sa += dx12;
+		sb += dx02;
+		if (a > b)
+			std::swap(a, b);
+		spans.add(y, a, b);
+	}
+}
+
+// Adafruit_GFX's Bresenham walk, one window per run of pixels on the same row (column when steep)
+void MCUFRIEND_kbv::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+	const bool steep = abs(y1 - y0) > abs(x1 - x0);
+	if (steep)
+		std::swap(x0, y0), std::swap(x1, y1);
+	if (x0 > x1)
+		std::swap(x0, x1), std::swap(y0, y1);
+	const int16_t dx = x1 - x0, dy = abs(y1 - y0), ystep = (y0 < y1) ? 1 : -1;
+	int16_t err = dx / 2;
+	for (int16_t start = x0; x0 <= x1; x0++)
+	{
+		err -= dy;
+		if (err >= 0 && x0 < x1)
+			continue;
+		if (steep)
+			fillClipped(*this, y0, start, 1, x0 - start + 1, color);
+		else
+			fillClipped(*this, start, y0, x0 - start + 1, 1, color);
+		if (err < 0)
+		{
+			y0 += ystep;
+			err += dx;
+		}
+		start = x0 + 1;
+	}
+}
+
+// midpoint steps x = xa .. xb at distance d from the quarter circle centres (cx0, cy0) .. (cx1, cy1),
+// mirrored into four horizontal and four vertical spans.  xa == 0 is the run that joins the edges
+static void outlineRun(MCUFRIEND_kbv &tft, int16_t cx0, int16_t cy0, int16_t cx1, int16_t cy1, int16_t d, int16_t xa, int16_t xb, uint16_t color)
+{
+	if (xa == 0)
+	{
+		fillClipped(tft, cx0 - xb, cy0 - d, cx1 - cx0 + 2 * xb + 1, 1, color);
+		fillClipped(tft, cx0 - xb, cy1 + d, cx1 - cx0 + 2 * xb + 1, 1, color);
+		fillClipped(tft, cx0 - d, cy0 - xb, 1, cy1 - cy0 + 2 * xb + 1, color);
+		fillClipped(tft, cx1 + d, cy0 - xb, 1, cy1 - cy0 + 2 * xb + 1, color);
+		return;
+	}
+	const int16_t n = xb - xa + 1;
+	fillClipped(tft, cx0 - xb, cy0 - d, n, 1, color);
+	fillClipped(tft, cx1 + xa, cy0 - d, n, 1, color);
+	fillClipped(tft, cx0 - xb, cy1 + d, n, 1, color);
+	fillClipped(tft, cx1 + xa, cy1 + d, n, 1, color);
+	fillClipped(tft, cx0 - d, cy0 - xb, 1, n, color);
+	fillClipped(tft, cx0 - d, cy1 + xa, 1, n, color);
+	fillClipped(tft, cx1 + d, cy0 - xb, 1, n, color);
+	fillClipped(tft, cx1 + d, cy1 + xa, 1, n, color);
+}
+
+// a round rect outline with the pixels of Adafruit_GFX.  a circle is the one with no straight edges
+static void outline(MCUFRIEND_kbv &tft, int16_t cx0, int16_t cy0, int16_t cx1, int16_t cy1, int16_t r, uint16_t color)
+{
+	int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+	int16_t d = r, xa = 0, xb = 0;
+	while (x < y)
+	{
+		if (f >= 0)
+		{
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
+		if (y == d)
+		{
+			xb = x;
+			continue;
+		}
+		outlineRun(tft, cx0, cy0, cx1, cy1, d, xa, xb, color);
+		d = y, xa = xb = x;
+	}
+	outlineRun(tft, cx0, cy0, cx1, cy1, d, xa, xb, color);
+}
+
+void MCUFRIEND_kbv::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+	outline(*this, x0, y0, x0, y0, r, color);
+}
+
+void MCUFRIEND_kbv::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color)
+{
+	const int16_t most = ((w < h) ? w : h) / 2;
+	if (r > most)
+		r = most;
+	outline(*this, x + r, y + r, x + w - r - 1, y + h - r - 1, r, color);
+}
+
+// read back as many rows (or as much of a row) as fit the line buffer, blend, write back with one window.
+// clipped to the screen.  a chunk is several rows only when no columns are clipped, so it is always
+// contiguous in a w x h source and blend() gets its offset there
+template <class Blend>
+static void readModifyWrite(MCUFRIEND_kbv &tft, int16_t x, int16_t y, int16_t w, int16_t h, Blend blend)
+{
+	const int16_t c0 = (x < 0) ? -x : 0, c1 = (tft.width() - x < w) ? tft.width() - x : w;
+	const int16_t r0 = (y < 0) ? -y : 0, r1 = (tft.height() - y < h) ? tft.height() - y : h;
+	if (c0 >= c1 || r0 >= r1)
+		return;
+	uint16_t line[LINE_PIXELS];
+	const int16_t vw = c1 - c0;
+	const int16_t rows = (vw == w && w <= LINE_PIXELS) ? LINE_PIXELS / w : 1, cols = (vw <= LINE_PIXELS) ? vw : LINE_PIXELS;
+	for (int16_t row = r0; row < r1; row += rows)
+	{
+		const int16_t nr = (r1 - row < rows) ? r1 - row : rows;
+		for (int16_t col = c0; col < c1; col += cols)
+		{
+			const int16_t nc = (c1 - col < cols) ? c1 - col : cols;
+			tft.readGRAM(x + col, y + row, line, nc, nr);
+			blend(line, nc * nr, (int32_t)row * w + col);
+			tft.setAddrWindow(x + col, y + row, x + col + nc - 1, y + row + nr - 1);
+			tft.pushColors(line, nc * nr, true);
+		}
+	}
+}
+
+// the colour is constant, so two pixels are blended per 32-bit operation
+void MCUFRIEND_kbv::fillRectAlpha(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, uint8_t alpha)
+{
+	if (alpha == 0)
+		return;
+	if (alpha == 255)
+	{
+		fillRect(x, y, w, h, color);
+		return;
+	}
+	const Blend565x2 blend2(color, alpha);
+	readModifyWrite(*this, x, y, w, h, [=](uint16_t *p, int16_t n, int32_t) {
+		for (; n >= 2; n -= 2, p += 2)
+		{
+			const uint32_t out = blend2(p[0] | ((uint32_t)p[1] << 16));
+			p[0] = out;
+			p[1] = out >> 16;
+		}
+		if (n)
+			*p = blend565(color, *p, alpha);
+	});
+}
+
+void MCUFRIEND_kbv::drawRGBBitmapAlpha(int16_t x, int16_t y, const uint16_t *bitmap, const uint8_t *alpha, int16_t w, int16_t h)
+{
+	readModifyWrite(*this, x, y, w, h, [=](uint16_t *p, int16_t n, int32_t at) {
+		for (int32_t k = at; n > 0; --n, k++, p++)
+			*p = blend565(pgm_read_word(bitmap + k), *p, pgm_read_byte(alpha + k));
+	});
+}
+
+void MCUFRIEND_kbv::drawAlphaMask(int16_t x, int16_t y, const uint8_t *mask, int16_t w, int16_t h, uint16_t color)
+{
+	readModifyWrite(*this, x, y, w, h, [=](uint16_t *p, int16_t n, int32_t at) {
+		for (const uint8_t *m = mask + at; n > 0; --n, p++)
+			*p = blend565(color, *p, pgm_read_byte(m++));
+	});
+}
+
+bool MCUFRIEND_kbv::drawQ565(int16_t x, int16_t y, const uint8_t *image)
+{
+	Qoi565Decoder q(image, true);
+	if (!q.begin())
+		return false;
+	uint16_t line[LINE_PIXELS];
+	setAddrWindow(x, y, x + q.width() - 1, y + q.height() - 1);
+	bool first = true;
+	for (int32_t n = (int32_t)q.width() * q.height(); n > 0; n -= LINE_PIXELS, first = false)
+	{
+		const int16_t k = (n < LINE_PIXELS) ? n : LINE_PIXELS;
+		q.read(line, k);
+		pushColors(line, k, first);
+	}
+	return true;
+}
+
+void MCUFRIEND_kbv::drawRLE565(int16_t x, int16_t y, const uint8_t *data, int16_t w, int16_t h)
+{
+	uint16_t line[LINE_PIXELS];
+	Rle565Decoder rle(data, true);
+	setAddrWindow(x, y, x + w - 1, y + h - 1);
+	bool first = true;
+	for (int32_t n = (int32_t)w * h; n > 0; n -= LINE_PIXELS, first = false)
+	{
+		const int16_t k = (n < LINE_PIXELS) ? n : LINE_PIXELS;
+		rle.read(line, k);
+		pushColors(line, k, first);
+	}
+}
+
+// each data byte is two nibble lookups: 4, 2 or 1 pixels per nibble from a table built from the palette.
+// 8 bpp indexes the palette directly.  other depths draw nothing
+void MCUFRIEND_kbv::drawIndexed(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t bpp, const uint8_t *data, const uint16_t *palette, bool pgmData, bool pgmPalette)
+{
+	if (bpp != 1 && bpp != 2 && bpp != 4 && bpp != 8)
+		return;
+	const int16_t c0 = (x < 0) ? -x : 0, c1 = (width() - x < w) ? width() - x : w;
+	const int16_t r0 = (y < 0) ? -y : 0, r1 = (height() - y < h) ? height() - y : h;
+	if (c0 >= c1 || r0 >= r1)
+		return;
+	uint16_t line[LINE_PIXELS + 16];  //whole bytes are expanded: up to 7 pixels either side of the chunk
+	uint16_t lut[64];
+	const uint8_t ppn = 4 / bpp, mask = (1 << bpp) - 1;
+	for (uint8_t nib = 0; nib < 16 && bpp < 8; nib++)
+		for (uint8_t i = 0; i < ppn; i++)
+		{
+			const uint8_t index = (nib >> (4 - bpp * (i + 1))) & mask;
+			lut[nib * ppn + i] = pgmPalette ? pgm_read_word(palette + index) : palette[index];
+		}
+	const int16_t stride = ((int32_t)w * bpp + 7) / 8;
+	setAddrWindow(x + c0, y + r0, x + c1 - 1, y + r1 - 1);
+	bool first = true;
+	data += (int32_t)r0 * stride;
+	for (int16_t row = r0; row < r1; row++, data += stride)
+	{
+		for (int16_t col = c0; col < c1; col += LINE_PIXELS)
+		{
+			const int16_t n = (c1 - col < LINE_PIXELS) ? c1 - col : LINE_PIXELS;
+			const int32_t bit = (int32_t)col * bpp;
+			const uint8_t skip = (bit & 7) / bpp;
+			const uint8_t *src = data + (bit >> 3);
+			uint16_t *dst = line;
+			int16_t bytes = ((skip + n) * bpp + 7) / 8;
+			switch (bpp)
+			{
+			case 8:
+				for (; bytes > 0; --bytes)
+				{
+					const uint8_t b = pgmData ? pgm_read_byte(src++) : *src++;
+					*dst++ = pgmPalette ? pgm_read_word(palette + b) : palette[b];
+				}
+				break;
+			case 4:
+				for (; bytes > 0; --bytes, dst += 2)
+				{
+					const uint8_t b = pgmData ? pgm_read_byte(src++) : *src++;
+					dst[0] = lut[b >> 4];
+					dst[1] = lut[b & 0x0F];
+				}
+				break;
+			case 2:
+				for (; bytes > 0; --bytes, dst += 4)
+				{
+					const uint8_t b = pgmData ? pgm_read_byte(src++) : *src++;
+					memcpy(dst, lut + (b >> 4) * 2, 2 * sizeof(uint16_t));
+					memcpy(dst + 2, lut + (b & 0x0F) * 2, 2 * sizeof(uint16_t));
+				}
+				break;
+			case 1:
+				for (; bytes > 0; --bytes, dst += 8)
+				{
+					const uint8_t b = pgmData ? pgm_read_byte(src++) : *src++;
+					memcpy(dst, lut + (b >> 4) * 4, 4 * sizeof(uint16_t));
+					memcpy(dst + 4, lut + (b & 0x0F) * 4, 4 * sizeof(uint16_t));
+				}
+				break;
+			}
+			pushColors(line + skip, n, first);
+			first = false;
+		}
+	}
+}
+
+// CASET alone when the span is on the row of the previous one
+void MCUFRIEND_kbv::setSpanWindow(int16_t x, int16_t x1, int16_t y, bool sameRow)
+{
+	if constexpr (_lcd_capable & MIPI_DCS_REV1)
+	{
+		if (sameRow)
+		{
+			WriteCmdParam4(_SC, x >> 8, x, x1 >> 8, x1);
+			return;
+		}
+	}
+	setAddrWindow(x, y, x1, y);
+}
+
+// transparent 1-bpp: every run of set bits is one window, and runs after the first on a row only move CASET
+void MCUFRIEND_kbv::drawMono(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, bool pgm, bool lsbFirst)
+{
+	const int16_t c0 = (x < 0) ? -x : 0, c1 = (width() - x < w) ? width() - x : w;
+	const int16_t r0 = (y < 0) ? -y : 0, r1 = (height() - y < h) ? height() - y : h;
+	const int16_t stride = (w + 7) / 8;
+	const uint8_t hi = color >> 8, lo = color;
+	bitmap += (int32_t)r0 * stride;
+	for (int16_t row = r0; row < r1; row++, bitmap += stride)
+	{
+		bool sameRow = false;
+		int16_t start = -1;
+		for (int16_t col = 0; col <= w; col++)
+		{
+			bool set = false;
+			if (col < w)
+			{
+				const uint8_t b = pgm ? pgm_read_byte(bitmap + (col >> 3)) : bitmap[col >> 3];
+				if ((col & 7) == 0 && (b == 0x00 || b == 0xFF) && col + 8 <= w) //whole byte: no change or no run end inside
+				{
+					if (b == 0 ? start < 0 : start >= 0)
+					{
+						col += 7;
+						continue;
+					}
+				}
+				set = (b >> (lsbFirst ? (col & 7) : 7 - (col & 7))) & 1;
+			}
+			if (set && start < 0)
+				start = col;
+			else if (!set && start >= 0)
+			{
+				const int16_t s = (start < c0) ? c0 : start, e = (col > c1) ? c1 : col;
+				if (s < e)
+				{
+					setSpanWindow(x + s, x + e - 1, y + row, sameRow);
+					sameRow = true;
+					CS_ACTIVE;
+					WriteCmd(_MW);
+					for (int16_t n = e - s; n > 0; --n)
+					{
+						write8(hi);
+						write8(lo);
+					}
+					CS_IDLE;
+				}
+				start = -1;
+			}
+		}
+	}
+}
+
+// each run of non-key pixels is one window and one pushColors.  runs, when given, lists them per row as
+// count, then start and length for each: nothing is scanned
+void MCUFRIEND_kbv::drawKeyed(int16_t x, int16_t y, const uint16_t *data, const uint16_t *runs, int16_t w, int16_t h, uint16_t key, bool pgm)
+{
+	const int16_t c0 = (x < 0) ? -x : 0, c1 = (width() - x < w) ? width() - x : w;
+	const int16_t r1 = (height() - y < h) ? height() - y : h;
+	for (int16_t row = 0; row < r1; row++, data += w)
+	{
+		bool sameRow = false;
+		int16_t n = runs ? pgm_read_word(runs++) : 0;
+		for (int16_t col = 0; runs ? n-- > 0 : col < w; )
+		{
+			int16_t start, end;
+			if (runs)
+			{
+				start = pgm_read_word(runs++);
+				end = start + pgm_read_word(runs++);
+			}
+			else
+			{
+				while (col < w && (pgm ? pgm_read_word(data + col) : data[col]) == key)
+					col++;
+				start = col;
+				while (col < w && (pgm ? pgm_read_word(data + col) : data[col]) != key)
+					col++;
+				end = col;
+			}
+			if (start < c0)
+				start = c0;
+			if (end > c1)
+				end = c1;
+			if (y + row < 0 || start >= end)
+				continue;
+			setSpanWindow(x + start, x + end - 1, y + row, sameRow);
+			sameRow = true;
+			if (pgm)
+				pushColors((const uint8_t *)(data + start), end - start, true);
+			else
+				pushColors((uint16_t *)(data + start), end - start, true);
+		}
+	}
+}
+
+// one window for the visible part of the destination.  a source row is expanded horizontally into the
+// line buffer and replayed scale times; when the visible row fits the buffer it is only expanded once
+void MCUFRIEND_kbv::drawScaled(int16_t x, int16_t y, const uint16_t *data, int16_t w, int16_t h, uint8_t scale, bool pgm)
+{
+	if (scale == 0 || w <= 0 || h <= 0)
+		return;
+	const int32_t dw = (int32_t)w * scale, dh = (int32_t)h * scale;
+	const int32_t c0 = (x < 0) ? -x : 0, c1 = (width() - x < dw) ? width() - x : dw;
+	const int32_t r0 = (y < 0) ? -y : 0, r1 = (height() - y < dh) ? height() - y : dh;
+	if (c0 >= c1 || r0 >= r1)
+		return;
+	uint16_t line[LINE_PIXELS];
+	const bool once = c1 - c0 <= LINE_PIXELS;
+	int32_t expanded = -1;
+	setAddrWindow(x + c0, y + r0, x + c1 - 1, y + r1 - 1);
+	bool first = true;
+	for (int32_t r = r0; r < r1; r++)
+	{
+		const uint16_t *src = data + (r / scale) * w;
+		if (scale == 1)
+		{
+			if (pgm)
+				pushColors((const uint8_t *)(src + c0), c1 - c0, first);
+			else
+				pushColors((uint16_t *)(src + c0), c1 - c0, first);
+			first = false;
+			continue;
+		}
+		if (once && r / scale == expanded)
+		{
+			pushColors(line, c1 - c0, first);
+			continue;
+		}
+		expanded = r / scale;
+		for (int32_t c = c0; c < c1; c += LINE_PIXELS)
+		{
+			const int16_t n = (c1 - c < LINE_PIXELS) ? c1 - c : LINE_PIXELS;
+			int32_t i = c / scale;
+			uint8_t k = scale - c % scale;  //what is left of the first source pixel
+			uint16_t *dst = line;
+			for (int16_t left = n; left > 0; i++, k = scale)
+			{
+				const uint16_t color = pgm ? pgm_read_word(src + i) : src[i];
+				for (; k > 0 && left > 0; --k, --left)
+					*dst++ = color;
+			}
+			pushColors(line, n, first);
+			first = false;
+		}
+	}
+}
+
+// map GRAM rows [r0, r1) to the logical band that the current rotation puts there
+static void scrollBand(uint8_t rotation, int16_t r0, int16_t r1, int16_t w, int16_t h, int16_t scrollH, int16_t *band)
+{
+	const int16_t start = (rotation & 2) ? scrollH - r1 : r0;
+	if (rotation & 1)
+		band[0] = start, band[1] = 0, band[2] = r1 - r0, band[3] = h;
+	else
+		band[0] = 0, band[1] = start, band[2] = w, band[3] = r1 - r0;
+}
+
+// The new screen is painted band by band in the same order as a plain repaint.
+// SLIDEs paint into the GRAM rows that the hardware scroll has just moved off the panel,
+// so the old screen appears to be pushed out.  The offset wraps back to 0 on the last band.
+// WIPEs reveal the new screen behind a moving edge.
+// Bands are sized from the elapsed time so the whole transition fits into ms.
+void MCUFRIEND_kbv::transition(uint8_t mode, BandPainter paint, void *ctx, uint16_t ms)
+{
+	const bool slide = mode <= SLIDE_DOWN;
+	const int16_t total = slide ? HEIGHT : (mode <= WIPE_UP) ? height() : width();
+	const uint32_t start = millis();
+	int16_t done = 0, band[4];
+
+	while (done < total)
+	{
+		const uint32_t t = millis() - start;
+		const int16_t target = (t >= ms) ? total : (int16_t)((int32_t)total * t / ms);
+		if (target <= done)
+		{
+			yield(); //ahead of schedule
+			continue;
+		}
+		switch (mode)
+		{
+		case SLIDE_UP:
+			scrollBand(rotation, done, target, width(), height(), HEIGHT, band);
+			break;
+		case SLIDE_DOWN:
+			scrollBand(rotation, HEIGHT - target, HEIGHT - done, width(), height(), HEIGHT, band);
+			break;
+		case WIPE_DOWN:
+			band[0] = 0, band[1] = done, band[2] = width(), band[3] = target - done;
+			break;
+		case WIPE_UP:
+			band[0] = 0, band[1] = height() - target, band[2] = width(), band[3] = target - done;
+			break;
+		case WIPE_RIGHT:
+			band[0] = done, band[1] = 0, band[2] = target - done, band[3] = height();
+			break;
+		default: //WIPE_LEFT
+			band[0] = width() - target, band[1] = 0, band[2] = target - done, band[3] = height();
+			break;
+		}
+		paint(*this, band[0], band[1], band[2], band[3], ctx);
+		if (slide)
+			vertScroll(0, HEIGHT, (mode == SLIDE_UP) ? target : -target); //offset of +-HEIGHT resets to 0
+		done = target;
+	}
+}
+
 void MCUFRIEND_kbv::invertDisplay(boolean i)
 {
 	uint8_t val;
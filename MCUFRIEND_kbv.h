@@ -16,6 +16,58 @@
 #include "Adafruit_GFX.h"
 #endif
 
+// pixels in the line buffers of the blits, which live on the stack
+#if defined(__AVR__)
+#define LINE_PIXELS 32
+#else
+#define LINE_PIXELS 320
+#endif
+
+class MCUFRIEND_kbv;
+
+// the static screen background, re-streamed instead of read back when something is erased.
+// eraseRect() only passes rectangles on the screen
+class BackgroundProvider {
+	public:
+	virtual void     erase(MCUFRIEND_kbv &tft, int16_t x, int16_t y, int16_t w, int16_t h) = 0;
+	virtual uint16_t pixel(int16_t x, int16_t y) = 0;
+};
+
+// a repeating pattern for the Brush fills and fillRectShader().  it is anchored to the screen
+// origin, so neighbouring fills line up.  each pattern row is expanded once and then copied
+class Brush {
+	public:
+	enum { MAX_W = 32 };
+	Brush(int16_t w, int16_t h) : _w((w < 1) ? 1 : (w > MAX_W) ? (int16_t)MAX_W : w), _h((h < 1) ? 1 : h), _stride((w < 1) ? 1 : w) {}
+	void     operator()(int16_t x, int16_t y, uint16_t *dst, int16_t n);
+	protected:
+	virtual void     expand(int16_t row, uint16_t *dst) = 0;  // _w pixels of a pattern row
+	int16_t  _w, _h, _stride, _row = -1;                       // _stride is the full width of the data
+	uint16_t _line[MAX_W];
+};
+
+// 1-bpp pattern up to 32 wide in two colours, set bits are fg.  PROGMEM rows start on a byte,
+// first pixel in the high bit, like drawBitmap().  a wider pattern repeats its first 32 columns
+class PatternBrush : public Brush {
+	public:
+	enum { HORIZONTAL, VERTICAL, DIAGONAL, BACK_DIAGONAL, CROSS, DIAGONAL_CROSS, DOTS, CHECKER };  // 8x8
+	PatternBrush(const uint8_t *bits, int16_t w, int16_t h, uint16_t fg, uint16_t bg) : Brush(w, h), _bits(bits), _fg(fg), _bg(bg) {}
+	PatternBrush(uint8_t style, uint16_t fg, uint16_t bg);
+	protected:
+	virtual void     expand(int16_t row, uint16_t *dst);
+	const uint8_t *_bits;
+	uint16_t _fg, _bg;
+};
+
+// PROGMEM 565 tile up to 32 wide.  a wider tile repeats its first 32 columns
+class TileBrush : public Brush {
+	public:
+	TileBrush(const uint16_t *tile, int16_t w, int16_t h) : Brush(w, h), _tile(tile) {}
+	protected:
+	virtual void     expand(int16_t row, uint16_t *dst);
+	const uint16_t *_tile;
+};
+
 class MCUFRIEND_kbv : public Adafruit_GFX {
 
 	public:
@@ -38,20 +90,164 @@ class MCUFRIEND_kbv : public Adafruit_GFX {
 	uint16_t readReg(uint16_t reg, int8_t index=0);
 	int16_t  readGRAM(int16_t x, int16_t y, uint16_t *block, int16_t w, int16_t h);
 	uint16_t readPixel(int16_t x, int16_t y) { uint16_t color; readGRAM(x, y, &color, 1, 1); return color; }
+	void     readColors(uint16_t *block, int16_t n, bool first);   // read back from the current window, like pushColors
+	// read any size of region through a small buffer: whole rows per chunk when they fit.
+	// sink must not use the panel, the next chunk continues the read where this one stopped
+	typedef void (*ReadSink)(const uint16_t *block, int16_t n, void *ctx);
+	void     readGRAM(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t *buffer, int16_t size, ReadSink sink, void *ctx = NULL);
 	void     setAddrWindow(int16_t x, int16_t y, int16_t x1, int16_t y1);
 	void     pushColors(uint16_t *block, int16_t n, bool first);
 	void     pushColors(uint8_t *block, int16_t n, bool first);
 	void     pushColors(const uint8_t *block, int16_t n, bool first, bool bigend = false);
     void     vertScroll(int16_t top, int16_t scrollines, int16_t offset);
+	// read back and rewritten a line at a time, overlap is allowed.  only the part where both source and
+	// destination are on the screen is copied.  full-width vertical moves take the same path, not
+	// vertScroll(): a hardware scroll would leave the panel offset from the GRAM that later drawing uses
+	void     copyRect(int16_t srcX, int16_t srcY, int16_t w, int16_t h, int16_t dstX, int16_t dstY);
+	// RLE compressed backing store in a RAM buffer.  saveRegion() returns the bytes used, 0 if it did not fit
+	size_t   saveRegion(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t *buf, size_t size);
+	void     restoreRegion(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t *buf);
+	void     setBackground(BackgroundProvider *bg) { _background = bg; }
+	BackgroundProvider *background(void) const { return _background; }
+	void     eraseRect(int16_t x, int16_t y, int16_t w, int16_t h);     // from the background provider, black without one
+	void     eraseText(int16_t x, int16_t y, const char *text);         // what print(text) at x, y covers with the current font
+	// alpha blending over what is on the panel: 0 = transparent, 255 = opaque.  bitmaps and masks are PROGMEM.
+	// clipped to the screen
+	void     fillRectAlpha(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, uint8_t alpha);
+	void     drawRGBBitmapAlpha(int16_t x, int16_t y, const uint16_t *bitmap, const uint8_t *alpha, int16_t w, int16_t h);
+	void     drawAlphaMask(int16_t x, int16_t y, const uint8_t *mask, int16_t w, int16_t h, uint16_t color);
+	bool     drawQ565(int16_t x, int16_t y, const uint8_t *image);  // PROGMEM Q565 (utility/qoi565.h), false if not one
+	void     drawRLE565(int16_t x, int16_t y, const uint8_t *data, int16_t w, int16_t h);  // PROGMEM utility/rle565.h packets
+	// 1, 2, 4 or 8 bits per pixel through a 565 palette, rows start on a byte, first pixel in the high bits.
+	// const data / palette are PROGMEM, the others RAM.  clipped to the screen
+	void     drawIndexedBitmap(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t bpp, const uint8_t *data, const uint16_t *palette) { drawIndexed(x, y, w, h, bpp, data, palette, true, true); }
+	void     drawIndexedBitmap(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t bpp, const uint8_t *data, uint16_t *palette)       { drawIndexed(x, y, w, h, bpp, data, palette, true, false); }
+	void     drawIndexedBitmap(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t bpp, uint8_t *data, const uint16_t *palette)       { drawIndexed(x, y, w, h, bpp, data, palette, false, true); }
+	void     drawIndexedBitmap(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t bpp, uint8_t *data, uint16_t *palette)             { drawIndexed(x, y, w, h, bpp, data, palette, false, false); }
+	// Adafruit_GFX 1-bpp bitmaps without a window per pixel: with a background through one window,
+	// transparent with one window per run of set bits.  drawBitmap(x, y, canvas.getBuffer(), w, h, color, bg)
+	// sends a whole GFXcanvas1
+	void     drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color)              { drawMono(x, y, bitmap, w, h, color, true, false); }
+	void     drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg) { uint16_t pal[2] = { bg, color }; drawIndexed(x, y, w, h, 1, bitmap, pal, true, false); }
+	void     drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color)                    { drawMono(x, y, bitmap, w, h, color, false, false); }
+	void     drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg)       { uint16_t pal[2] = { bg, color }; drawIndexed(x, y, w, h, 1, bitmap, pal, false, false); }
+	void     drawXBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color)             { drawMono(x, y, bitmap, w, h, color, true, true); }
+	// 565 bitmaps with a transparent key colour.  const data is PROGMEM.  the runs form takes the PROGMEM
+	// run index made by extras/tools/keyed_runs instead of scanning for the key
+	void     drawRGBBitmapKeyed(int16_t x, int16_t y, const uint16_t *data, int16_t w, int16_t h, uint16_t key) { drawKeyed(x, y, data, NULL, w, h, key, true); }
+	void     drawRGBBitmapKeyed(int16_t x, int16_t y, uint16_t *data, int16_t w, int16_t h, uint16_t key)       { drawKeyed(x, y, data, NULL, w, h, key, false); }
+	void     drawRGBBitmapKeyed(int16_t x, int16_t y, const uint16_t *data, const uint16_t *runs, int16_t w, int16_t h) { drawKeyed(x, y, data, runs, w, h, 0, true); }
+	// every pixel becomes a scale x scale block, clipped to the screen and all through one window.  const data is PROGMEM
+	void     drawRGBBitmapScaled(int16_t x, int16_t y, const uint16_t *data, int16_t w, int16_t h, uint8_t scale) { drawScaled(x, y, data, w, h, scale, true); }
+	void     drawRGBBitmapScaled(int16_t x, int16_t y, uint16_t *data, int16_t w, int16_t h, uint8_t scale)       { drawScaled(x, y, data, w, h, scale, false); }
+	// procedural fill through one window.  shader(x, y) returns the 565 colour of a pixel, or
+	// shader(x, y, dst, n) fills the n pixels of a row from x.  screen coordinates, clipped to the screen.
+	// gradients are in MCUFRIEND_shader.h
+	template <class F>
+	void     fillRectShader(int16_t x, int16_t y, int16_t w, int16_t h, F &&shader);
+	// pattern fills that cost the bus what a solid fill does: one window per rectangle, one per row
+	// in the corners of a round rect
+	void     fillRect(int16_t x, int16_t y, int16_t w, int16_t h, Brush &brush) { fillRectShader(x, y, w, h, brush); }
+	void     drawFastHLine(int16_t x, int16_t y, int16_t w, Brush &brush)        { fillRectShader(x, y, w, 1, brush); }
+	void     fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, Brush &brush);
+	// filled shapes with the pixels of Adafruit_GFX, as spans from the top down.  rows in a row with the
+	// same columns share one window, and circle rows come from a cache of the last few radii
+	void     fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+	void     fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+	void     fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+	// lines and outlines with the pixels of Adafruit_GFX, one window per horizontal or vertical run
+	virtual void     drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+	void     drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+	void     drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+
+	// screen transitions: paint(tft, x, y, w, h, ctx) must draw the new screen inside the given band only
+	typedef void (*BandPainter)(MCUFRIEND_kbv &tft, int16_t x, int16_t y, int16_t w, int16_t h, void *ctx);
+	enum { SLIDE_UP, SLIDE_DOWN, WIPE_DOWN, WIPE_UP, WIPE_RIGHT, WIPE_LEFT };  // SLIDEs follow the scroll axis
+	void     transition(uint8_t mode, BandPainter paint, void *ctx = NULL, uint16_t ms = 200);
 
     protected:
 	uint32_t readReg32(uint16_t reg);
 	uint32_t readReg40(uint16_t reg);
+	void     drawIndexed(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t bpp, const uint8_t *data, const uint16_t *palette, bool pgmData, bool pgmPalette);
+	void     drawMono(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, bool pgm, bool lsbFirst);
+	void     setSpanWindow(int16_t x, int16_t x1, int16_t y, bool sameRow);
+	void     drawKeyed(int16_t x, int16_t y, const uint16_t *data, const uint16_t *runs, int16_t w, int16_t h, uint16_t key, bool pgm);
+	void     drawScaled(int16_t x, int16_t y, const uint16_t *data, int16_t w, int16_t h, uint8_t scale, bool pgm);
     uint16_t  _lcd_xor;
 
 	private:
 	uint16_t _lcd_ID, _lcd_rev, _lcd_madctl, _lcd_drivOut, _MC, _MP, _MW, _SC, _EC, _SP, _EP;
 	bool _resetPerformed = false;
+	BackgroundProvider *_background = NULL;
+};
+
+// a span shader if it takes (x, y, dst, n), else one call per pixel
+template <class F>
+inline auto shadeSpan(F &f, int16_t x, int16_t y, uint16_t *dst, int16_t n, int) -> decltype(f(x, y, dst, n), void())
+{
+	f(x, y, dst, n);
+}
+
+template <class F>
+inline void shadeSpan(F &f, int16_t x, int16_t y, uint16_t *dst, int16_t n, long)
+{
+	for (int16_t i = 0; i < n; i++)
+		dst[i] = f(x + i, y);
+}
+
+template <class F>
+void MCUFRIEND_kbv::fillRectShader(int16_t x, int16_t y, int16_t w, int16_t h, F &&shader)
+{
+#if defined(__AVR__)
+	enum { CHUNK = 32 };
+#else
+	enum { CHUNK = 320 };
+#endif
+	const int16_t x0 = (x < 0) ? 0 : x, x1 = (x + w > width()) ? width() : x + w;
+	const int16_t y0 = (y < 0) ? 0 : y, y1 = (y + h > height()) ? height() : y + h;
+	if (x0 >= x1 || y0 >= y1)
+		return;
+	uint16_t line[CHUNK];
+	setAddrWindow(x0, y0, x1 - 1, y1 - 1);
+	bool first = true;
+	for (int16_t row = y0; row < y1; row++)
+		for (int16_t col = x0; col < x1; col += CHUNK, first = false)
+		{
+			const int16_t n = (x1 - col < CHUNK) ? x1 - col : CHUNK;
+			shadeSpan(shader, col, row, line, n, 0);
+			pushColors(line, n, first);
+		}
+}
+
+class SolidBackground : public BackgroundProvider {
+	public:
+	SolidBackground(uint16_t color) : _color(color) {}
+	virtual void     erase(MCUFRIEND_kbv &tft, int16_t x, int16_t y, int16_t w, int16_t h) { tft.fillRect(x, y, w, h, _color); }
+	virtual uint16_t pixel(int16_t, int16_t) { return _color; }
+	protected:
+	uint16_t _color;
+};
+
+// PROGMEM 565 image with its top left corner at x, y.  It must cover every erased rectangle
+class ImageBackground : public BackgroundProvider {
+	public:
+	ImageBackground(const uint16_t *image, int16_t w, int16_t h, int16_t x = 0, int16_t y = 0) : _image(image), _w(w), _h(h), _x(x), _y(y) {}
+	virtual void     erase(MCUFRIEND_kbv &tft, int16_t x, int16_t y, int16_t w, int16_t h);
+	virtual uint16_t pixel(int16_t x, int16_t y) { return pgm_read_word(_image + (int32_t)(y - _y) * _w + (x - _x)); }
+	protected:
+	const uint16_t *_image;
+	int16_t  _w, _h, _x, _y;
+};
+
+// PROGMEM 565 tile repeated from the screen origin
+class TiledBackground : public BackgroundProvider {
+	public:
+	TiledBackground(const uint16_t *tile, int16_t w, int16_t h) : _tile(tile), _w(w), _h(h) {}
+	virtual void     erase(MCUFRIEND_kbv &tft, int16_t x, int16_t y, int16_t w, int16_t h);
+	virtual uint16_t pixel(int16_t x, int16_t y);
+	protected:
+	const uint16_t *_tile;
+	int16_t  _w, _h;
 };
 
 // New color definitions.  thanks to Bodmer
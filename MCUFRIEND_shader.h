@@ -0,0 +1,117 @@
+/*
+ * Gradient shaders for MCUFRIEND_kbv::fillRectShader().
+ *
+ * Both are span shaders: the position along the gradient is stepped across a row with
+ * additions only.  LinearGradient keeps it in 16.16 fixed point; RadialGradient keeps the squared
+ * distance and moves a ring level up or down when it crosses the next ring, so there is no square
+ * root per pixel.  Colours are interpolated per 565 channel, and a colour is only recomputed when
+ * the level changes.
+ *
+ *   tft.fillRectShader(0, 0, 240, 40, LinearGradient(0, 0, TFT_NAVY, 0, 39, TFT_CYAN));
+ *   tft.fillRectShader(x, y, w, h, [](int16_t x, int16_t y) { return ((x ^ y) & 8) ? TFT_WHITE : TFT_BLACK; });
+ */
+
+#ifndef MCUFRIEND_SHADER_H_
+#define MCUFRIEND_SHADER_H_
+
+#include "MCUFRIEND_kbv.h"
+
+// c0 to c1 in 257 steps: 0 is c0, 256 is c1
+class GradientRamp {
+
+	public:
+	GradientRamp(uint16_t c0, uint16_t c1) : _r0(c0 >> 11), _g0((c0 >> 5) & 0x3F), _b0(c0 & 0x1F)
+	{
+		_dr = (c1 >> 11) - _r0;
+		_dg = ((c1 >> 5) & 0x3F) - _g0;
+		_db = (c1 & 0x1F) - _b0;
+	}
+	uint16_t color(uint16_t a)
+	{
+		if (a != _a)
+		{
+			_a = a;
+			_color = ((_r0 + ((_dr * a + 128) >> 8)) << 11) | ((_g0 + ((_dg * a + 128) >> 8)) << 5) | (_b0 + ((_db * a + 128) >> 8));
+		}
+		return _color;
+	}
+
+	protected:
+	int16_t  _r0, _g0, _b0, _dr, _dg, _db;
+	uint16_t _a = 0xFFFF, _color = 0;
+};
+
+// c0 at x0, y0 to c1 at x1, y1, constant across the line between them and clamped past its ends
+class LinearGradient : public GradientRamp {
+
+	public:
+	LinearGradient(int16_t x0, int16_t y0, uint16_t c0, int16_t x1, int16_t y1, uint16_t c1) : GradientRamp(c0, c1), _x0(x0), _y0(y0)
+	{
+		const int32_t dx = x1 - x0, dy = y1 - y0, len2 = (dx || dy) ? dx * dx + dy * dy : 1;
+		_sx = (dx * 65536L + ((dx < 0) ? -len2 : len2) / 2) / len2;  //position per pixel, 16.16
+		_sy = (dy * 65536L + ((dy < 0) ? -len2 : len2) / 2) / len2;
+	}
+	void     operator()(int16_t x, int16_t y, uint16_t *dst, int16_t n)
+	{
+		int32_t t = (int32_t)(x - _x0) * _sx + (int32_t)(y - _y0) * _sy;
+		for (; n > 0; --n, t += _sx)
+			*dst++ = color((t <= 0) ? 0 : (t >= 65536L) ? 256 : (t + 128) >> 8);
+	}
+
+	protected:
+	int16_t  _x0, _y0;
+	int32_t  _sx, _sy;
+};
+
+// c0 at cx, cy to c1 at radius r (up to 2000) and beyond
+class RadialGradient : public GradientRamp {
+
+	public:
+	RadialGradient(int16_t cx, int16_t cy, int16_t r, uint16_t c0, uint16_t c1) : GradientRamp(c0, c1), _cx(cx), _cy(cy)
+	{
+		_r = (r > 0) ? r : 1;
+	}
+	void     operator()(int16_t x, int16_t y, uint16_t *dst, int16_t n)
+	{
+		int32_t dx = x - _cx, dy = y - _cy, d2 = dx * dx + dy * dy;
+		const uint32_t start = ((uint32_t)isqrt(d2) << 8) / _r;
+		int16_t level = (start < 256) ? start : 256;
+		int32_t lo = ring(level), hi = ring(level + 1);
+		for (; n > 0; --n, d2 += 2 * dx + 1, dx++)
+		{
+			while (d2 >= hi)
+				lo = hi, hi = ring(++level + 1);
+			while (d2 < lo)
+				hi = lo, lo = ring(--level);
+			*dst++ = color(level);
+		}
+	}
+
+	protected:
+	int32_t  ring(int16_t level)       // smallest squared distance at this level
+	{
+		if (level > 256)
+			return INT32_MAX;
+		const int32_t d = ((int32_t)level * _r + 15) >> 4;  //4 fraction bits
+		return (d * d + 255) >> 8;
+	}
+	static uint16_t isqrt(uint32_t v)
+	{
+		uint32_t root = 0;
+		for (uint32_t bit = 1UL << 30; bit; bit >>= 2)
+		{
+			if (v >= root + bit)
+			{
+				v -= root + bit;
+				root = (root >> 1) + bit;
+			}
+			else
+				root >>= 1;
+		}
+		return root;
+	}
+
+	int16_t  _cx, _cy, _r;
+};
+
+#endif
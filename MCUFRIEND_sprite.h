@@ -0,0 +1,151 @@
+/*
+ * Sprites with a GRAM backed save-under.
+ *
+ * Sprite<W, H> keeps the W x H pixels it covers in a static buffer (W * H * 2 bytes, no heap).
+ * The background is read back from the panel before the sprite is drawn and written again when
+ * it moves or hides.  When the old and new positions overlap only the uncovered strips are
+ * restored and only the newly covered strips are read; the rest moves inside the buffer.
+ * Images are PROGMEM 565 arrays.  With a key colour those pixels show the saved background,
+ * so the sprite is still drawn with one window.
+ * When the panel has a BackgroundProvider nothing is read back: uncovered strips are erased and
+ * key pixels are taken from the provider.
+ */
+
+#ifndef MCUFRIEND_SPRITE_H_
+#define MCUFRIEND_SPRITE_H_
+
+#include "MCUFRIEND_kbv.h"
+
+template <int16_t W, int16_t H>
+class Sprite {
+
+	public:
+	Sprite(MCUFRIEND_kbv &tft) : _tft(tft) {}
+	void     draw(int16_t x, int16_t y, const uint16_t *image)               { place(x, y, image, false, 0); }
+	void     draw(int16_t x, int16_t y, const uint16_t *image, uint16_t key) { place(x, y, image, true, key); }
+	void     moveTo(int16_t x, int16_t y) { if (_image) place(x, y, _image, _keyed, _key); }
+	void     hide(void)
+	{
+		if (!_visible)
+			return;
+		restore(clip(_x, _y, W, H));
+		_visible = false;
+	}
+	bool     visible(void) const { return _visible; }
+	int16_t  x(void) const { return _x; }
+	int16_t  y(void) const { return _y; }
+
+	protected:
+	struct Rect { int16_t x, y, w, h; };
+
+	Rect     clip(int16_t x, int16_t y, int16_t w, int16_t h) const
+	{
+		int16_t x1 = x + w, y1 = y + h;
+		if (x < 0)
+			x = 0;
+		if (y < 0)
+			y = 0;
+		if (x1 > _tft.width())
+			x1 = _tft.width();
+		if (y1 > _tft.height())
+			y1 = _tft.height();
+		return {x, y, (int16_t)(x1 > x ? x1 - x : 0), (int16_t)(y1 > y ? y1 - y : 0)};
+	}
+
+	// write part of the saved background back to the panel
+	void     restore(const Rect &r)
+	{
+		if (r.w <= 0 || r.h <= 0)
+			return;
+		if (_tft.background())
+		{
+			_tft.eraseRect(r.x, r.y, r.w, r.h);
+			return;
+		}
+		_tft.setAddrWindow(r.x, r.y, r.x + r.w - 1, r.y + r.h - 1);
+		uint16_t *p = _under + (r.y - _y) * W + (r.x - _x);
+		for (int16_t row = 0; row < r.h; row++, p += W)
+			_tft.pushColors(p, r.w, row == 0);
+	}
+
+	// read part of the background at the new position, one window with RAMRD continue per row
+	void     save(const Rect &r, int16_t nx, int16_t ny)
+	{
+		if (r.w <= 0 || r.h <= 0 || _tft.background())
+			return;
+		_tft.setAddrWindow(r.x, r.y, r.x + r.w - 1, r.y + r.h - 1);
+		uint16_t *p = _under + (r.y - ny) * W + (r.x - nx);
+		for (int16_t row = 0; row < r.h; row++, p += W)
+			_tft.readColors(p, r.w, row == 0);
+	}
+
+	// the parts of a that are not inside b: up to four strips
+	void     subtract(const Rect &a, const Rect &b, void (Sprite::*op)(const Rect &, int16_t, int16_t), int16_t nx, int16_t ny)
+	{
+		const int16_t top = b.y > a.y ? b.y : a.y, bottom = (b.y + b.h < a.y + a.h) ? b.y + b.h : a.y + a.h;
+		(this->*op)({a.x, a.y, a.w, (int16_t)(top - a.y)}, nx, ny);
+		(this->*op)({a.x, bottom, a.w, (int16_t)(a.y + a.h - bottom)}, nx, ny);
+		(this->*op)({a.x, top, (int16_t)(b.x - a.x), (int16_t)(bottom - top)}, nx, ny);
+		(this->*op)({(int16_t)(b.x + b.w), top, (int16_t)(a.x + a.w - b.x - b.w), (int16_t)(bottom - top)}, nx, ny);
+	}
+	void     restoreAt(const Rect &r, int16_t, int16_t) { restore(r); }
+
+	void     place(int16_t nx, int16_t ny, const uint16_t *image, bool keyed, uint16_t key)
+	{
+		const Rect to = clip(nx, ny, W, H);
+		if (!_visible)
+			save(to, nx, ny);
+		else
+		{
+			const Rect from = clip(_x, _y, W, H);
+			const Rect both = clip(max(_x, nx), max(_y, ny), min(_x, nx) + W - max(_x, nx), min(_y, ny) + H - max(_y, ny));
+			if (both.w <= 0 || both.h <= 0 || from.w <= 0 || to.w <= 0)
+			{
+				restore(from);
+				save(to, nx, ny);
+			}
+			else
+			{
+				subtract(from, both, &Sprite::restoreAt, nx, ny);
+				// keep the shared background: a 2D memmove inside the buffer
+				const int32_t shift = (int32_t)(ny - _y) * W + (nx - _x);
+				for (int16_t i = 0; i < both.h; i++)
+				{
+					const int16_t row = (shift > 0) ? i : both.h - 1 - i;
+					uint16_t *dst = _under + (both.y + row - ny) * W + (both.x - nx);
+					memmove(dst, dst + shift, both.w * sizeof(uint16_t));
+				}
+				subtract(to, both, &Sprite::save, nx, ny);
+			}
+		}
+		_x = nx, _y = ny, _image = image, _keyed = keyed, _key = key, _visible = true;
+		if (to.w <= 0 || to.h <= 0)
+			return;
+
+		uint16_t line[W];
+		BackgroundProvider *bg = _tft.background();
+		_tft.setAddrWindow(to.x, to.y, to.x + to.w - 1, to.y + to.h - 1);
+		for (int16_t row = 0; row < to.h; row++)
+		{
+			const int16_t offset = (to.y + row - ny) * W + (to.x - nx);
+			for (int16_t i = 0; i < to.w; i++)
+			{
+				const uint16_t color = pgm_read_word(image + offset + i);
+				if (!keyed || color != key)
+					line[i] = color;
+				else
+					line[i] = bg ? bg->pixel(to.x + i, to.y + row) : _under[offset + i];
+			}
+			_tft.pushColors(line, to.w, row == 0);
+		}
+	}
+
+	MCUFRIEND_kbv &_tft;
+	uint16_t _under[W * H];
+	const uint16_t *_image = NULL;
+	int16_t  _x = 0, _y = 0;
+	uint16_t _key = 0;
+	bool     _keyed = false, _visible = false;
+};
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * Raw 565 video from an SD File or any other Stream, see utility/raw_video.h.
+ *
+ *   uint16_t row[160];
+ *   VideoPlayer<File> video(tft, file, row, 160, 120);
+ *   video.setFps(15);
+ *   while (video.play()) ;
+ */
+
+#ifndef MCUFRIEND_VIDEO_H_
+#define MCUFRIEND_VIDEO_H_
+
+#include "MCUFRIEND_kbv.h"
+#include "utility/raw_video.h"
+
+template <class Source>
+using VideoPlayer = RawVideo<Source, MCUFRIEND_kbv>;
+
+#endif
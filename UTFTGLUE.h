@@ -126,17 +126,7 @@ class UTFTGLUE : public MCUFRIEND_kbv
         }
     }
     void drawBitmap(int x, int y, int sx, int sy, const uint16_t *data, int scale=1) {
-        uint16_t color;
-        MCUFRIEND_kbv::setAddrWindow(x, y, x + sx*scale - 1, y + sy*scale - 1);
-        if (scale == 1) MCUFRIEND_kbv::pushColors((const uint8_t*)data, sx * sy, 1);
-        else {
-            for (int row = 0; row < sy; row++) {
-                for (int col = 0; col < sx; col++) {
-                    color = pgm_read_word(data + (row*sx + col)*1);
-                    MCUFRIEND_kbv::fillRect(x+col*scale, y+row*scale, scale, scale, color);
-                }
-            }
-        }
+        MCUFRIEND_kbv::drawRGBBitmapScaled(x, y, data, sx, sy, scale);
     }
 //  void drawBitmap(int x, int y, int sx, int sy, bitmapdatatype data, int deg, int rox, int roy);
 //  void lcdOff();
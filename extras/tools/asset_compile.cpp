@@ -0,0 +1,237 @@
+/*
+ * Compile images into a C header, each in whichever encoding suits the board best.
+ *
+ *   g++ -O2 -o asset_compile asset_compile.cpp
+ *   ./asset_compile [-board uno|mega|due|esp32] [-slack percent] logo.png arrow.ppm > assets.h
+ *
+ * Every image is tried as raw 565, through a palette at the fewest bits per pixel that hold its
+ * colours, as RLE (utility/rle565.h) and as Q565 (utility/qoi565.h); all of them are lossless.
+ * The draw time of each is estimated from the board's bus time per pixel and decode cycles, and
+ * the smallest encoding that draws within slack percent of the fastest one wins.  The boards
+ * with little flash default to a bigger slack, and an image that would not fit the board's flash
+ * at all takes its smallest encoding.  The figures are rough: measure on the board.
+ *
+ * For an image logo.png the header has logo_W, logo_H, the data and a draw_logo(tft, x, y) macro
+ * that calls the matching MCUFRIEND_kbv blit.  The report goes to stderr.
+ */
+
+#include <ctype.h>
+#include <algorithm>
+#include <map>
+#include "image_io.h"
+#include "../../utility/rle565.h"
+#include "../../utility/qoi565.h"
+
+enum { RAW, PALETTE, RLE, Q565, FORMATS };
+static const char *formatName[FORMATS] = { "raw", "pal", "rle", "q565" };
+
+struct Board {
+	const char *name;
+	float    mhz, busNs;                 // bus time per pixel, with the write strobes the library uses
+	int      slack;                      // percent of the fastest draw time traded for flash
+	uint32_t flash;                      // bytes
+	// decode cycles per pixel, per byte of compressed data for RLE and Q565
+	float    raw, palette, palette8, rlePixel, rleByte, q565Pixel, q565Byte;
+};
+
+static const Board boards[] = {
+	{ "uno",   16,  1000, 100, 32768L,   8, 10, 14, 8, 40, 10, 60 },
+	{ "mega",  16,  1500, 50,  262144L,  8, 10, 14, 8, 40, 10, 60 },
+	{ "due",   84,  200,  25,  524288L,  4, 6,  8,  4, 20, 5,  30 },
+	{ "esp32", 240, 120,  10,  4194304L, 4, 6,  8,  4, 20, 5,  30 },
+};
+
+struct Encoding {
+	int      format, bpp = 16;
+	std::vector<uint8_t> bytes;          // raw is kept as 16-bit words for a uint16_t array
+	std::vector<uint16_t> words, palette;
+	size_t   size(void) const { return bytes.size() + 2 * (words.size() + palette.size()); }
+	float    drawUs = 0;
+};
+
+static float estimateUs(const Board &b, const Encoding &e, size_t pixels)
+{
+	float cycles = 0;
+	switch (e.format)
+	{
+	case RAW: cycles = pixels * b.raw; break;
+	case PALETTE: cycles = pixels * (e.bpp == 8 ? b.palette8 : b.palette); break;
+	case RLE: cycles = pixels * b.rlePixel + e.bytes.size() * b.rleByte; break;
+	case Q565: cycles = pixels * b.q565Pixel + e.bytes.size() * b.q565Byte; break;
+	}
+	return pixels * b.busNs / 1000 + cycles / b.mhz;
+}
+
+static std::vector<Encoding> encode(const Image &img)
+{
+	const size_t n = img.pixels.size();
+	std::vector<Encoding> all;
+	Encoding raw;
+	raw.format = RAW;
+	raw.words = img.pixels;
+	all.push_back(raw);
+
+	std::map<uint16_t, uint8_t> index;
+	for (uint16_t c : img.pixels)
+		if (index.size() <= 256 && !index.count(c))
+		{
+			const size_t i = index.size();
+			index[c] = i;
+		}
+	if (index.size() <= 256)
+	{
+		Encoding pal;
+		pal.format = PALETTE;
+		pal.bpp = index.size() <= 2 ? 1 : index.size() <= 4 ? 2 : index.size() <= 16 ? 4 : 8;
+		pal.palette.resize(index.size());
+		for (const auto &i : index)
+			pal.palette[i.second] = i.first;
+		const size_t stride = ((size_t)img.w * pal.bpp + 7) / 8;
+		pal.bytes.assign(stride * img.h, 0);
+		for (int y = 0; y < img.h; y++)
+			for (int x = 0; x < img.w; x++)
+			{
+				const int bit = x * pal.bpp;
+				pal.bytes[y * stride + bit / 8] |= index[img.pixels[(size_t)y * img.w + x]] << (8 - pal.bpp - bit % 8);
+			}
+		all.push_back(pal);
+	}
+
+	Encoding rle;
+	rle.format = RLE;
+	rle.bytes.resize(n * 3);
+	Rle565Encoder r(rle.bytes.data(), rle.bytes.size());
+	for (uint16_t c : img.pixels)
+		r.push(c);
+	rle.bytes.resize(r.finish());
+	all.push_back(rle);
+
+	Encoding q;
+	q.format = Q565;
+	q.bytes.resize(Q565_HEADER + n * 3);
+	Qoi565Encoder qe(q.bytes.data(), q.bytes.size(), img.w, img.h);
+	qe.push(img.pixels.data(), n);
+	q.bytes.resize(qe.finish());
+	all.push_back(q);
+	return all;
+}
+
+static std::string assetName(const char *path)
+{
+	std::string s = path;
+	s = s.substr(s.find_last_of("/\\") + 1);
+	s = s.substr(0, s.find('.'));
+	for (char &c : s)
+		if (!isalnum((unsigned char)c))
+			c = '_';
+	if (s.empty() || isdigit((unsigned char)s[0]))
+		s = "img_" + s;
+	return s;
+}
+
+static void writeAsset(const std::string &name, const Image &img, const Encoding &e, const Board &b)
+{
+	const char *id = name.c_str();
+	printf("\n// %s: %dx%d %s", id, img.w, img.h, formatName[e.format]);
+	if (e.format == PALETTE)
+		printf("%d", e.bpp);
+	printf(", %zu bytes (raw 565 %zu), about %.2f ms on %s\n", e.size(), img.pixels.size() * 2, e.drawUs / 1000, b.name);
+	printf("#define %s_W %d\n#define %s_H %d\n", id, img.w, id, img.h);
+	switch (e.format)
+	{
+	case RAW:
+		writeArray(stdout, id, e.words.data(), e.words.size());
+		printf("#define draw_%s(tft, x, y) (tft).drawRGBBitmapScaled(x, y, %s, %s_W, %s_H, 1)\n", id, id, id, id);
+		break;
+	case PALETTE:
+		writeArray(stdout, id, e.bytes.data(), e.bytes.size());
+		writeArray(stdout, (name + "_pal").c_str(), e.palette.data(), e.palette.size());
+		printf("#define draw_%s(tft, x, y) (tft).drawIndexedBitmap(x, y, %s_W, %s_H, %d, %s, %s_pal)\n", id, id, id, e.bpp, id, id);
+		break;
+	case RLE:
+		writeArray(stdout, id, e.bytes.data(), e.bytes.size());
+		printf("#define draw_%s(tft, x, y) (tft).drawRLE565(x, y, %s, %s_W, %s_H)\n", id, id, id, id);
+		break;
+	case Q565:
+		writeArray(stdout, id, e.bytes.data(), e.bytes.size());
+		printf("#define draw_%s(tft, x, y) (tft).drawQ565(x, y, %s)\n", id, id);
+		break;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const Board *board = &boards[0];
+	int slack = -1, arg = 1;
+	for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2)
+	{
+		if (!strcmp(argv[arg], "-slack"))
+			slack = atoi(argv[arg + 1]);
+		else if (!strcmp(argv[arg], "-board"))
+		{
+			board = NULL;
+			for (const Board &b : boards)
+				if (!strcmp(b.name, argv[arg + 1]))
+					board = &b;
+			if (!board)
+			{
+				fprintf(stderr, "%s: unknown board %s\n", argv[0], argv[arg + 1]);
+				return 2;
+			}
+		}
+		else
+			break;
+	}
+	if (arg >= argc)
+	{
+		fprintf(stderr, "usage: %s [-board uno|mega|due|esp32] [-slack percent] image.png|image.ppm|image.bmp ...\n", argv[0]);
+		return 2;
+	}
+	if (slack < 0)
+		slack = board->slack;
+
+	printf("// made by asset_compile for %s, slack %d%%\n", board->name, slack);
+	fprintf(stderr, "%-16s %9s %-6s %8s %8s %6s %9s\n", "asset", "size", "format", "bytes", "raw", "saved", "draw ms");
+	size_t total = 0, totalRaw = 0;
+	float totalUs = 0;
+	for (; arg < argc; arg++)
+	{
+		Image img;
+		if (!loadImage(argv[arg], img) || img.w > 32767 || img.h > 32767)
+		{
+			fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[arg]);
+			return 1;
+		}
+		std::vector<Encoding> all = encode(img);
+		float fastest = 1e30f;
+		for (Encoding &e : all)
+			fastest = std::min(fastest, e.drawUs = estimateUs(*board, e, img.pixels.size()));
+		const Encoding *best = NULL;
+		for (const Encoding &e : all)
+			if (e.drawUs <= fastest * (100 + slack) / 100 && (!best || e.size() < best->size()))
+				best = &e;
+		if (best->size() > board->flash)
+			for (const Encoding &e : all)
+				if (e.size() < best->size())
+					best = &e;
+		const std::string name = assetName(argv[arg]);
+		writeAsset(name, img, *best, *board);
+
+		const size_t raw = img.pixels.size() * 2;
+		char size[16], format[8];
+		snprintf(size, sizeof(size), "%dx%d", img.w, img.h);
+		snprintf(format, sizeof(format), best->format == PALETTE ? "%s%d" : "%s", formatName[best->format], best->bpp);
+		fprintf(stderr, "%-16s %9s %-6s %8zu %8zu %5.0f%% %9.2f\n", name.c_str(), size, format, best->size(), raw,
+		        100.0 - 100.0 * best->size() / raw, best->drawUs / 1000);
+		fprintf(stderr, "%16s", "");
+		for (const Encoding &e : all)
+			fprintf(stderr, " %s %zu/%.2f", formatName[e.format], e.size(), e.drawUs / 1000);
+		fprintf(stderr, "\n");
+		total += best->size(), totalRaw += raw, totalUs += best->drawUs;
+	}
+	fprintf(stderr, "%-16s %9s %-6s %8zu %8zu %5.0f%% %9.2f\n", "total", "", "", total, totalRaw,
+	        totalRaw ? 100.0 - 100.0 * total / totalRaw : 0.0, totalUs / 1000);
+	if (total > board->flash)
+		fprintf(stderr, "%s: %zu bytes do not fit the %u of flash on %s\n", argv[0], total, (unsigned)board->flash, board->name);
+	return 0;
+}
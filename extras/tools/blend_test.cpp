@@ -0,0 +1,62 @@
+/*
+ * Check the 565 alpha blends of utility/blend565.h (fillRectAlpha, drawRGBBitmapAlpha, drawAlphaMask)
+ * against the reference round((fg * a + bg * (255 - a)) / 255) per channel.
+ *
+ *   g++ -O2 -o blend_test blend_test.cpp
+ *   ./blend_test
+ *
+ * Every alpha from 0 to 255 is tried with every pair of channel values, through blend565() and
+ * through both lanes of Blend565x2.  Mismatches go to stderr; the exit status is 1 if there are any.
+ */
+
+#include <stdio.h>
+#include "../../utility/blend565.h"
+
+static unsigned reference(unsigned fg, unsigned bg, unsigned a)
+{
+	return (fg * a + bg * (255 - a) + 127) / 255;
+}
+
+static uint16_t reference565(uint16_t fg, uint16_t bg, unsigned a)
+{
+	return (reference(fg >> 11, bg >> 11, a) << 11) | (reference((fg >> 5) & 0x3F, (bg >> 5) & 0x3F, a) << 5)
+	       | reference(fg & 0x1F, bg & 0x1F, a);
+}
+
+// i from 0 to 63 gives every red, green and blue value
+static uint16_t color(unsigned i)
+{
+	return ((i & 0x1F) << 11) | (i << 5) | (0x1F - (i & 0x1F));
+}
+
+static unsigned failures;
+
+static void check(const char *what, uint16_t fg, uint16_t bg, unsigned a, uint16_t got)
+{
+	const uint16_t want = reference565(fg, bg, a);
+	if (got != want && failures++ < 20)
+		fprintf(stderr, "%s: fg %04X bg %04X a %u gives %04X, not %04X\n", what, fg, bg, a, got, want);
+}
+
+int main(void)
+{
+	unsigned long tried = 0;
+	for (unsigned a = 0; a <= 255; a++)
+		for (unsigned i = 0; i < 64; i++)
+		{
+			const uint16_t fg = color(i);
+			const Blend565x2 blend2(fg, a);
+			for (unsigned j = 0; j < 64; j++)
+			{
+				const uint16_t bg0 = color(j), bg1 = ~color(63 - j);
+				check("blend565", fg, bg0, a, blend565(fg, bg0, a));
+				check("blend565", fg, bg1, a, blend565(fg, bg1, a));
+				const uint32_t two = blend2(bg0 | ((uint32_t)bg1 << 16));
+				check("Blend565x2 low", fg, bg0, a, two);
+				check("Blend565x2 high", fg, bg1, a, two >> 16);
+				tried += 2;
+			}
+		}
+	printf("%lu blends, %u wrong\n", tried, failures);
+	return failures != 0;
+}
@@ -0,0 +1,172 @@
+/*
+ * Encode a sequence of frames as a delta animation and print it as a C header for DeltaAnimation
+ * (MCUFRIEND_anim.h).
+ *
+ *   g++ -O2 -o delta_encode delta_encode.cpp
+ *   ./delta_encode [-loop] spinner frame0.ppm frame1.ppm ... > spinner.h
+ *
+ * Frames are PNG, binary PPM or BMP, all the same size.  Each frame is compared with the one before:
+ * the changed pixels of a row become spans, gaps too short to be worth a new window are bridged,
+ * and spans are stacked into rectangles while the pixels that did not change cost less than
+ * another window would.  -loop adds the delta from the last frame back to the first.
+ * The bytes and pixels of every frame go to stderr.
+ */
+
+#include <string.h>
+#include <algorithm>
+#include "image_io.h"
+#include "../../utility/rle565.h"
+
+// bus bytes to open a window: CASET and PASET with 4 parameters each, RAMWR
+enum { WINDOW_BYTES = 11 };
+
+struct Rect {
+	int      x0, x1, y0, y1;         // inclusive
+	int      area(void) const { return (x1 - x0 + 1) * (y1 - y0 + 1); }
+};
+
+static std::vector<Rect> changedRects(const Image *prev, const Image &cur)
+{
+	std::vector<Rect> done, open;
+	if (!prev)
+		return {{0, cur.w - 1, 0, cur.h - 1}};
+	for (int y = 0; y < cur.h; y++)
+	{
+		const uint16_t *a = &prev->pixels[(size_t)y * cur.w], *b = &cur.pixels[(size_t)y * cur.w];
+		std::vector<Rect> spans;
+		for (int x = 0; x < cur.w; x++)
+		{
+			if (a[x] == b[x])
+				continue;
+			if (!spans.empty() && (x - spans.back().x1 - 1) * 2 <= WINDOW_BYTES)
+				spans.back().x1 = x;
+			else
+				spans.push_back({x, x, y, y});
+		}
+		std::vector<Rect> next;
+		for (const Rect &s : spans)
+		{
+			// the rectangle that takes the span for the fewest extra pixels, if any beats a new window
+			int best = -1, bestCost = WINDOW_BYTES;
+			for (size_t i = 0; i < open.size(); i++)
+			{
+				const Rect &r = open[i];
+				const Rect u = {std::min(r.x0, s.x0), std::max(r.x1, s.x1), r.y0, y};
+				const int cost = (u.area() - r.area() - (s.x1 - s.x0 + 1)) * 2;
+				if (cost <= bestCost)
+					best = i, bestCost = cost;
+			}
+			for (size_t i = 0; best < 0 && i < next.size(); i++)
+			{
+				Rect &r = next[i];   // already grown on this row: only widening costs
+				const Rect u = {std::min(r.x0, s.x0), std::max(r.x1, s.x1), r.y0, y};
+				if ((u.area() - r.area() - (s.x1 - s.x0 + 1)) * 2 <= WINDOW_BYTES)
+				{
+					r = u;
+					best = -2;
+				}
+			}
+			if (best >= 0)
+			{
+				Rect r = open[best];
+				open.erase(open.begin() + best);
+				next.push_back({std::min(r.x0, s.x0), std::max(r.x1, s.x1), r.y0, y});
+			}
+			else if (best == -1)
+				next.push_back(s);
+		}
+		done.insert(done.end(), open.begin(), open.end());
+		open = next;
+	}
+	done.insert(done.end(), open.begin(), open.end());
+	return done;
+}
+
+static void put16(std::vector<uint8_t> &out, unsigned v)
+{
+	out.push_back(v >> 8);
+	out.push_back(v);
+}
+
+static size_t encodeFrame(std::vector<uint8_t> &out, const Image *prev, const Image &cur, size_t &pixels)
+{
+	const size_t at = out.size();
+	const std::vector<Rect> rects = changedRects(prev, cur);
+	out.resize(at + 4);
+	put16(out, rects.size());
+	pixels = 0;
+	for (const Rect &r : rects)
+	{
+		const int w = r.x1 - r.x0 + 1, h = r.y1 - r.y0 + 1;
+		std::vector<uint16_t> px;
+		for (int y = r.y0; y <= r.y1; y++)
+			px.insert(px.end(), &cur.pixels[(size_t)y * cur.w + r.x0], &cur.pixels[(size_t)y * cur.w + r.x1 + 1]);
+		pixels += px.size();
+		std::vector<uint8_t> rle(px.size() * 3);
+		Rle565Encoder enc(rle.data(), rle.size());
+		for (uint16_t c : px)
+			enc.push(c);
+		const size_t n = enc.finish();
+		const bool useRle = n < px.size() * 2;
+		put16(out, r.x0);
+		put16(out, r.y0);
+		put16(out, w | (useRle ? 0x8000 : 0));
+		put16(out, h);
+		if (useRle)
+			out.insert(out.end(), rle.begin(), rle.begin() + n);
+		else
+			for (uint16_t c : px)
+				put16(out, c);
+	}
+	const size_t size = out.size() - at;
+	for (int i = 0; i < 4; i++)
+		out[at + i] = size >> (24 - 8 * i);
+	return size;
+}
+
+int main(int argc, char **argv)
+{
+	int arg = 1;
+	const bool loop = argc > 1 && strcmp(argv[1], "-loop") == 0;
+	arg += loop;
+	if (argc - arg < 2)
+	{
+		fprintf(stderr, "usage: %s [-loop] name frame0.png|frame0.ppm|frame0.bmp ...\n", argv[0]);
+		return 2;
+	}
+	const char *name = argv[arg++];
+	std::vector<Image> frames(argc - arg);
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		if (!loadImage(argv[arg + i], frames[i]) || frames[i].w > 32767 || frames[i].h > 32767)
+		{
+			fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[arg + i]);
+			return 1;
+		}
+		if (frames[i].w != frames[0].w || frames[i].h != frames[0].h)
+		{
+			fprintf(stderr, "%s: %s is not %dx%d\n", argv[0], argv[arg + i], frames[0].w, frames[0].h);
+			return 1;
+		}
+	}
+	const int w = frames[0].w, h = frames[0].h;
+	std::vector<uint8_t> out = {'d', '5', '6', '5'};
+	put16(out, w);
+	put16(out, h);
+	put16(out, frames.size());
+	out.push_back(loop && frames.size() > 1);
+	out.push_back(0);
+	for (size_t i = 0; i <= frames.size(); i++)
+	{
+		if (i == frames.size() && !(loop && frames.size() > 1))
+			break;
+		const Image *prev = i == 0 ? NULL : &frames[i - 1];
+		size_t pixels;
+		const size_t bytes = encodeFrame(out, prev, frames[i % frames.size()], pixels);
+		fprintf(stderr, "%s %3zu: %6zu bytes, %6zu pixels (%.1f%% of the frame)\n", i < frames.size() ? "frame" : "loop ",
+		        i % frames.size(), bytes, pixels, 100.0 * pixels / ((size_t)w * h));
+	}
+	printf("// %d frames of %dx%d, %zu bytes (raw 565 %zu)\n", (int)frames.size(), w, h, out.size(), frames.size() * w * h * 2);
+	writeArray(stdout, name, out.data(), out.size());
+	return 0;
+}
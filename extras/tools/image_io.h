@@ -0,0 +1,362 @@
+/*
+ * Image input and C header output for the host tools.
+ *
+ * loadImage() reads binary PPM (P6), non-interlaced PNG and the BMPs that utility/bmp_decoder.h
+ * understands, and returns the pixels as 565 in top-down row order.  PNG alpha is dropped.
+ * writeArray() prints a PROGMEM byte or 16-bit array that the library can draw straight from flash.
+ */
+
+#ifndef IMAGE_IO_H_
+#define IMAGE_IO_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../../utility/bmp_decoder.h"
+
+struct Image {
+	int      w = 0, h = 0;
+	std::vector<uint16_t> pixels;   // 565, top-down
+};
+
+inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) { return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3); }
+
+inline bool loadPPM(std::istream &in, Image &img)
+{
+	std::string magic;
+	int maxval = 0;
+	in >> magic;
+	for (int *v : {&img.w, &img.h, &maxval})
+	{
+		while (in >> std::ws && in.peek() == '#')
+			in.ignore(1 << 16, '\n');
+		in >> *v;
+	}
+	in.get();
+	if (magic != "P6" || !in || img.w <= 0 || img.h <= 0 || maxval != 255)
+		return false;
+	std::vector<uint8_t> rgb((size_t)img.w * img.h * 3);
+	if (!in.read((char *)rgb.data(), rgb.size()))
+		return false;
+	img.pixels.resize((size_t)img.w * img.h);
+	for (size_t i = 0; i < img.pixels.size(); i++)
+		img.pixels[i] = rgb565(rgb[3 * i], rgb[3 * i + 1], rgb[3 * i + 2]);
+	return true;
+}
+
+inline bool loadBMP(std::istream &in, Image &img)
+{
+	BmpDecoder<std::istream> bmp(in);
+	if (bmp.begin() != BMP_OK)
+		return false;
+	img.w = bmp.width();
+	img.h = bmp.height();
+	img.pixels.resize((size_t)img.w * img.h);
+	for (int r = 0; r < img.h; r++)
+	{
+		const int row = bmp.bottomUp() ? img.h - 1 - r : r;
+		if (bmp.read(&img.pixels[(size_t)row * img.w], img.w) != img.w)
+			return false;
+	}
+	return true;
+}
+
+// zlib inflate, enough for PNG: stored, fixed and dynamic Huffman blocks
+class Inflater {
+
+	public:
+	Inflater(const std::vector<uint8_t> &in) : _in(in) {}
+	bool     run(std::vector<uint8_t> &out)
+	{
+		if (_in.size() < 2 || (_in[0] & 0x0F) != 8 || (_in[1] & 0x20))
+			return false;
+		_pos = 2;
+		for (int last = 0; !last; )
+		{
+			last = bits(1);
+			const int type = bits(2);
+			if (type == 0)
+			{
+				_bit = 0, _bitCount = 0;
+				if (_pos + 4 > _in.size())
+					return false;
+				const size_t len = _in[_pos] | (_in[_pos + 1] << 8);
+				_pos += 4;
+				if (_pos + len > _in.size())
+					return false;
+				out.insert(out.end(), _in.begin() + _pos, _in.begin() + _pos + len);
+				_pos += len;
+				continue;
+			}
+			Huffman lit, dist;
+			if (type == 1)
+			{
+				uint8_t lengths[320];
+				for (int i = 0; i < 288; i++)
+					lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+				for (int i = 0; i < 30; i++)
+					lengths[288 + i] = 5;
+				lit.build(lengths, 288);
+				dist.build(lengths + 288, 30);
+			}
+			else if (type != 2 || !dynamicTables(lit, dist))
+				return false;
+			if (!block(out, lit, dist))
+				return false;
+		}
+		return !_overrun;
+	}
+
+	protected:
+	struct Huffman {
+		uint16_t count[16], symbol[320];
+		void     build(const uint8_t *lengths, int n)
+		{
+			uint16_t offs[16];
+			memset(count, 0, sizeof(count));
+			for (int i = 0; i < n; i++)
+				count[lengths[i]]++;
+			count[0] = 0;
+			offs[1] = 0;
+			for (int i = 1; i < 15; i++)
+				offs[i + 1] = offs[i] + count[i];
+			for (int i = 0; i < n; i++)
+				if (lengths[i])
+					symbol[offs[lengths[i]]++] = i;
+		}
+	};
+	int      bits(int n)
+	{
+		while (_bitCount < n)
+		{
+			if (_pos >= _in.size())
+			{
+				_overrun = true;
+				return 0;
+			}
+			_bit |= _in[_pos++] << _bitCount;
+			_bitCount += 8;
+		}
+		const int v = _bit & ((1 << n) - 1);
+		_bit >>= n;
+		_bitCount -= n;
+		return v;
+	}
+	int      decode(const Huffman &h)  // canonical codes, one bit at a time
+	{
+		for (int len = 1, code = 0, first = 0, index = 0; len < 16 && !_overrun; len++)
+		{
+			code |= bits(1);
+			const int count = h.count[len];
+			if (code - count < first)
+				return h.symbol[index + (code - first)];
+			index += count;
+			first = (first + count) << 1;
+			code <<= 1;
+		}
+		return -1;
+	}
+	bool     dynamicTables(Huffman &lit, Huffman &dist)
+	{
+		static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+		uint8_t lengths[320] = { 0 };
+		const int nlen = bits(5) + 257, ndist = bits(5) + 1, ncode = bits(4) + 4;
+		if (nlen > 286 || ndist > 30)
+			return false;
+		for (int i = 0; i < ncode; i++)
+			lengths[order[i]] = bits(3);
+		Huffman code;
+		code.build(lengths, 19);
+		for (int i = 0; i < nlen + ndist; )
+		{
+			int sym = decode(code), repeat, value = 0;
+			if (sym < 0)
+				return false;
+			if (sym < 16)
+			{
+				lengths[i++] = sym;
+				continue;
+			}
+			if (sym == 16)
+			{
+				if (i == 0)
+					return false;
+				value = lengths[i - 1];
+				repeat = 3 + bits(2);
+			}
+			else
+				repeat = (sym == 17) ? 3 + bits(3) : 11 + bits(7);
+			if (i + repeat > nlen + ndist)
+				return false;
+			while (repeat--)
+				lengths[i++] = value;
+		}
+		lit.build(lengths, nlen);
+		dist.build(lengths + nlen, ndist);
+		return true;
+	}
+	bool     block(std::vector<uint8_t> &out, const Huffman &lit, const Huffman &dist)
+	{
+		static const uint16_t lbase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		static const uint8_t lextra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		static const uint16_t dbase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		static const uint8_t dextra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+		for (;;)
+		{
+			int sym = decode(lit);
+			if (sym < 0 || _overrun)
+				return false;
+			if (sym < 256)
+				out.push_back(sym);
+			else if (sym == 256)
+				return true;
+			else
+			{
+				sym -= 257;
+				if (sym >= 29)
+					return false;
+				const int len = lbase[sym] + bits(lextra[sym]);
+				const int d = decode(dist);
+				if (d < 0 || d >= 30)
+					return false;
+				const size_t back = dbase[d] + bits(dextra[d]);
+				if (back > out.size())
+					return false;
+				for (int i = 0; i < len; i++)
+					out.push_back(out[out.size() - back]);
+			}
+		}
+	}
+
+	const std::vector<uint8_t> &_in;
+	size_t   _pos = 0;
+	uint32_t _bit = 0;
+	int      _bitCount = 0;
+	bool     _overrun = false;
+};
+
+inline bool loadPNG(std::istream &in, Image &img)
+{
+	static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	uint8_t head[8];
+	if (!in.read((char *)head, 8) || memcmp(head, sig, 8))
+		return false;
+	std::vector<uint8_t> idat, plte, raw;
+	int depth = 0, type = -1, interlace = 0;
+	for (;;)
+	{
+		uint8_t h[8];
+		if (!in.read((char *)h, 8))
+			return false;
+		const uint32_t len = (h[0] << 24) | (h[1] << 16) | (h[2] << 8) | h[3];
+		std::vector<uint8_t> chunk(len);
+		if (!in.read((char *)chunk.data(), len) || !in.ignore(4))   //CRC not checked
+			return false;
+		if (!memcmp(h + 4, "IHDR", 4) && len >= 13)
+		{
+			img.w = (chunk[0] << 24) | (chunk[1] << 16) | (chunk[2] << 8) | chunk[3];
+			img.h = (chunk[4] << 24) | (chunk[5] << 16) | (chunk[6] << 8) | chunk[7];
+			depth = chunk[8], type = chunk[9], interlace = chunk[12];
+		}
+		else if (!memcmp(h + 4, "PLTE", 4))
+			plte = chunk;
+		else if (!memcmp(h + 4, "IDAT", 4))
+			idat.insert(idat.end(), chunk.begin(), chunk.end());
+		else if (!memcmp(h + 4, "IEND", 4))
+			break;
+	}
+	static const int channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+	if (img.w <= 0 || img.h <= 0 || interlace || type < 0 || type > 6 || !channels[type] || (type == 3 && plte.empty()))
+		return false;
+	const int bitsPP = channels[type] * depth, bpp = (bitsPP + 7) / 8;
+	const size_t stride = ((size_t)img.w * bitsPP + 7) / 8;
+	if (!Inflater(idat).run(raw) || raw.size() < (stride + 1) * img.h)
+		return false;
+	// undo the row filters in place, each row after its filter byte
+	for (int y = 0; y < img.h; y++)
+	{
+		uint8_t *row = &raw[y * (stride + 1) + 1], *up = y ? row - stride - 1 : NULL;
+		const uint8_t filter = row[-1];
+		for (size_t i = 0; i < stride; i++)
+		{
+			const int a = i >= (size_t)bpp ? row[i - bpp] : 0, b = up ? up[i] : 0, c = (up && i >= (size_t)bpp) ? up[i - bpp] : 0;
+			const int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+			switch (filter)
+			{
+			case 1: row[i] += a; break;
+			case 2: row[i] += b; break;
+			case 3: row[i] += (a + b) / 2; break;
+			case 4: row[i] += (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c; break;
+			}
+		}
+	}
+	img.pixels.resize((size_t)img.w * img.h);
+	for (int y = 0; y < img.h; y++)
+	{
+		const uint8_t *row = &raw[y * (stride + 1) + 1];
+		for (int x = 0; x < img.w; x++)
+		{
+			// the high byte of each sample is enough for 565
+			auto sample = [&](int ch) -> int {
+				if (depth < 8)
+				{
+					const int bit = x * depth;
+					const int v = (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1);
+					return type == 3 ? v : v * 255 / ((1 << depth) - 1);
+				}
+				return row[(x * channels[type] + ch) * (depth / 8)];
+			};
+			uint8_t r, g, b;
+			if (type == 3)
+			{
+				const size_t i = sample(0) * 3;
+				if (i + 2 >= plte.size())
+					return false;
+				r = plte[i], g = plte[i + 1], b = plte[i + 2];
+			}
+			else if (type == 0 || type == 4)
+				r = g = b = sample(0);
+			else
+				r = sample(0), g = sample(1), b = sample(2);
+			img.pixels[(size_t)y * img.w + x] = rgb565(r, g, b);
+		}
+	}
+	return true;
+}
+
+inline bool loadImage(const char *path, Image &img)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		return false;
+	const int c = in.peek();
+	if (c == 'P')
+		return loadPPM(in, img);
+	if (c == 'B')
+		return loadBMP(in, img);
+	if (c == 0x89)
+		return loadPNG(in, img);
+	return false;
+}
+
+inline void writeArray(FILE *out, const char *name, const uint8_t *data, size_t n)
+{
+	fprintf(out, "const uint8_t %s[] PROGMEM = {", name);
+	for (size_t i = 0; i < n; i++)
+		fprintf(out, "%s0x%02X,", (i % 16) ? " " : "\n\t", data[i]);
+	fprintf(out, "\n};\n");
+}
+
+inline void writeArray(FILE *out, const char *name, const uint16_t *data, size_t n)
+{
+	fprintf(out, "const uint16_t %s[] PROGMEM = {", name);
+	for (size_t i = 0; i < n; i++)
+		fprintf(out, "%s0x%04X,", (i % 12) ? " " : "\n\t", data[i]);
+	fprintf(out, "\n};\n");
+}
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Print an image and its run index as a C header for MCUFRIEND_kbv::drawRGBBitmapKeyed(x, y, data, runs, w, h).
+ *
+ *   g++ -O2 -o keyed_runs keyed_runs.cpp
+ *   ./keyed_runs icon.ppm icon 0xF81F > icon.h
+ *
+ * The run index holds, for every row, the number of runs of non-key pixels followed by the start
+ * and length of each, so the blit does not compare pixels with the key at runtime.
+ */
+
+#include <stdlib.h>
+#include "image_io.h"
+
+int main(int argc, char **argv)
+{
+	if (argc != 4)
+	{
+		fprintf(stderr, "usage: %s image.png|image.ppm|image.bmp name key565\n", argv[0]);
+		return 2;
+	}
+	Image img;
+	if (!loadImage(argv[1], img))
+	{
+		fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	const uint16_t key = strtoul(argv[3], NULL, 0);
+	std::vector<uint16_t> runs;
+	for (int y = 0; y < img.h; y++)
+	{
+		const uint16_t *row = &img.pixels[(size_t)y * img.w];
+		const size_t count = runs.size();
+		runs.push_back(0);
+		for (int x = 0; x < img.w; )
+		{
+			while (x < img.w && row[x] == key)
+				x++;
+			const int start = x;
+			while (x < img.w && row[x] != key)
+				x++;
+			if (x > start)
+			{
+				runs.push_back(start);
+				runs.push_back(x - start);
+				runs[count]++;
+			}
+		}
+	}
+
+	const std::string name = argv[2], runsName = name + "_runs";
+	printf("// %s: %dx%d, key 0x%04X\n", argv[1], img.w, img.h, key);
+	printf("#define %s_W %d\n#define %s_H %d\n", argv[2], img.w, argv[2], img.h);
+	writeArray(stdout, name.c_str(), img.pixels.data(), img.pixels.size());
+	writeArray(stdout, runsName.c_str(), runs.data(), runs.size());
+	return 0;
+}
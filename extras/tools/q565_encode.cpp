@@ -0,0 +1,36 @@
+/*
+ * Compress an image to Q565 and print it as a C header for MCUFRIEND_kbv::drawQ565().
+ *
+ *   g++ -O2 -o q565_encode q565_encode.cpp
+ *   ./q565_encode splash.ppm splash > splash.h
+ *
+ * Input is PNG, binary PPM or BMP.  The sizes go to stderr.
+ */
+
+#include "image_io.h"
+#include "../../utility/qoi565.h"
+
+int main(int argc, char **argv)
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: %s image.png|image.ppm|image.bmp name\n", argv[0]);
+		return 2;
+	}
+	Image img;
+	if (!loadImage(argv[1], img) || img.w > 65535 || img.h > 65535)
+	{
+		fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	// worst case is a raw op per pixel
+	std::vector<uint8_t> out(Q565_HEADER + img.pixels.size() * 3);
+	Qoi565Encoder q(out.data(), out.size(), img.w, img.h);
+	q.push(img.pixels.data(), img.pixels.size());
+	const size_t n = q.finish();
+
+	printf("// %s: %dx%d Q565, %zu bytes (raw 565 %zu)\n", argv[1], img.w, img.h, n, img.pixels.size() * 2);
+	writeArray(stdout, argv[2], out.data(), n);
+	fprintf(stderr, "%dx%d: %zu bytes, %.1f%% of raw 565\n", img.w, img.h, n, 100.0 * n / (img.pixels.size() * 2));
+	return 0;
+}
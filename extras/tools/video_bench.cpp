@@ -0,0 +1,49 @@
+/*
+ * Measure how fast utility/raw_video.h gets raw 565 frames out of a file, with the panel replaced
+ * by a sink that only counts pixels.
+ *
+ *   g++ -O2 -o video_bench video_bench.cpp
+ *   ./video_bench clip.raw 240 180 [fps]
+ *
+ * A clip can be made with ffmpeg -i clip.mp4 -vf scale=240:180 -f rawvideo -pix_fmt rgb565le clip.raw
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <vector>
+#include "../../utility/raw_video.h"
+
+struct NullDisplay {
+	uint64_t pixels = 0;
+	void     setAddrWindow(int16_t, int16_t, int16_t, int16_t) {}
+	void     pushColors(uint16_t *, int16_t n, bool) { pixels += n; }
+};
+
+int main(int argc, char **argv)
+{
+	if (argc < 4)
+	{
+		fprintf(stderr, "usage: %s clip.raw width height [fps]\n", argv[0]);
+		return 2;
+	}
+	std::ifstream in(argv[1], std::ios::binary);
+	if (!in)
+	{
+		fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	const int w = atoi(argv[2]), h = atoi(argv[3]);
+	NullDisplay display;
+	std::vector<uint16_t> row(w);
+	RawVideo<std::ifstream, NullDisplay> video(display, in, row.data(), w, h);
+	if (argc > 4)
+		video.setFps(atoi(argv[4]));
+	while (video.play())
+		;
+	const auto &s = video.stats();
+	printf("%u frames, %u dropped, %.1f fps, %.1f MB/s\n", (unsigned)s.frames, (unsigned)s.dropped, s.fps(),
+	       s.elapsedUs ? display.pixels * 2.0 / s.elapsedUs : 0.0);
+	printf("read %u us, push %u us, wait %u us, bus idle %u%%\n", (unsigned)s.readUs, (unsigned)s.pushUs, (unsigned)s.waitUs, s.busIdle());
+	return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * Exact alpha blending of 565 colours.  No Arduino dependencies: extras/tools/blend_test checks it.
+ *
+ * Each channel is round((fg * a + bg * (255 - a)) / 255).  The division by 255 is done in two
+ * 16-bit lanes at once with add-and-shift.
+ */
+
+#ifndef BLEND565_H_
+#define BLEND565_H_
+
+#include <stdint.h>
+
+// round(x / 255) in each 16-bit lane, exact for x <= 65535 - 256
+static inline uint32_t div255Lanes(uint32_t x)
+{
+	x += 0x00800080;
+	return ((x + ((x >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+}
+
+// one pixel.  red and blue share a multiply
+static inline uint16_t blend565(uint16_t fg, uint16_t bg, uint8_t a)
+{
+	const uint32_t frb = (fg >> 11) | ((uint32_t)(fg & 0x1F) << 16);
+	const uint32_t brb = (bg >> 11) | ((uint32_t)(bg & 0x1F) << 16);
+	const uint32_t rb = div255Lanes(frb * a + brb * (255 - a));
+	const uint32_t g = div255Lanes(((fg >> 5) & 0x3F) * a + ((bg >> 5) & 0x3F) * (255 - a));
+	return (rb << 11) | (g << 5) | (rb >> 16);
+}
+
+// a constant colour over two pixels at once, one per 16-bit lane (the first in the low half)
+class Blend565x2 {
+
+	public:
+	Blend565x2(uint16_t color, uint8_t a) : _ia(255 - a)
+	{
+		const uint32_t c = color | ((uint32_t)color << 16);
+		_r = ((c >> 11) & 0x001F001F) * a;
+		_g = ((c >> 5) & 0x003F003F) * a;
+		_b = (c & 0x001F001F) * a;
+	}
+	uint32_t operator()(uint32_t bg) const
+	{
+		const uint32_t r = div255Lanes(_r + ((bg >> 11) & 0x001F001F) * _ia);
+		const uint32_t g = div255Lanes(_g + ((bg >> 5) & 0x003F003F) * _ia);
+		const uint32_t b = div255Lanes(_b + (bg & 0x001F001F) * _ia);
+		return (r << 11) | (g << 5) | b;
+	}
+
+	protected:
+	uint32_t _r, _g, _b;
+	uint8_t  _ia;
+};
+
+#endif
@@ -0,0 +1,217 @@
+/*
+ * Streaming BMP decoder.  No Arduino dependencies: the host tools use it too.
+ *
+ * Uncompressed BMPs with 1, 2, 4 or 8 bit palettes, 16 bit 555 / 565, 24 and 32 bit pixels are read
+ * front to back from a streamRead() source.  Nothing seeks: the rest of the header and the gap
+ * before the pixels are read through.  Rows come out in file order, so bottom-up files
+ * (bottomUp() is true) deliver the bottom row first.
+ * Bytes go through a cache refilled with one read call at a time and are converted to 565 a batch
+ * at a time.  RAM: the cache and a 565 palette.
+ */
+
+#ifndef BMP_DECODER_H_
+#define BMP_DECODER_H_
+
+#include <string.h>
+#include "stream_source.h"
+
+enum { BMP_OK = 0, BMP_ERR_READ = -1, BMP_ERR_FORMAT = -2, BMP_ERR_UNSUPPORTED = -3 };
+
+template <class Source>
+class BmpDecoder {
+
+	public:
+#if defined(__AVR__)
+	enum { CACHE = 64 };
+#else
+	enum { CACHE = 960 };            // a 320 pixel row of 24-bit
+#endif
+	BmpDecoder(Source &src) : _src(src) {}
+
+	int8_t   begin(void)             // read everything up to the first pixel
+	{
+		if (take(2) != 0x4D42)
+			return _short ? BMP_ERR_READ : BMP_ERR_FORMAT;
+		skip(8);                     // file size, reserved
+		const uint32_t offset = take(4), header = take(4);
+		const int32_t w = take(4), h = take(4);
+		take(2);                     // planes
+		_bpp = take(2);
+		const uint32_t compression = take(4);
+		skip(12);                    // image size, resolution
+		uint32_t colors = take(4);
+		take(4);
+		uint32_t pos = 54;
+		if (_short)
+			return BMP_ERR_READ;
+		if (header < 40 || w <= 0 || w > 32767 || h == 0 || h > 32767 || h < -32767 || offset < pos)
+			return BMP_ERR_FORMAT;
+		_width = w;
+		_height = (h < 0) ? -h : h;
+		_bottomUp = (h > 0);
+		_565 = false;
+		if (compression == 3)        // BI_BITFIELDS: the masks end a V4 / V5 header or follow a 40 byte one
+		{
+			const uint32_t r = take(4), g = take(4), b = take(4);
+			pos += 12;
+			if (_bpp == 16 && r == 0xF800 && g == 0x07E0 && b == 0x001F)
+				_565 = true;
+			else if (!(_bpp == 16 && r == 0x7C00 && g == 0x03E0 && b == 0x001F) &&
+			         !(_bpp == 32 && r == 0xFF0000 && g == 0xFF00 && b == 0xFF))
+				return BMP_ERR_UNSUPPORTED;
+		}
+		else if (compression != 0)
+			return BMP_ERR_UNSUPPORTED;
+		if (_bpp != 1 && _bpp != 2 && _bpp != 4 && _bpp != 8 && _bpp != 16 && _bpp != 24 && _bpp != 32)
+			return BMP_ERR_UNSUPPORTED;
+		if (14 + header > pos)
+			skip(14 + header - pos), pos = 14 + header;
+		if (_bpp <= 8)
+		{
+			if (colors == 0 || colors > (1UL << _bpp))
+				colors = 1UL << _bpp;
+			memset(_palette, 0, sizeof(_palette));
+			for (uint16_t i = 0; i < colors; i++)
+				_palette[i] = rgb(take(4));
+			pos += colors * 4;
+		}
+		if (offset < pos)
+			return BMP_ERR_FORMAT;
+		skip(offset - pos);
+		const uint32_t bytes = ((uint32_t)_width * _bpp + 7) / 8;
+		_pad = (4 - (bytes & 3)) & 3;
+		_col = 0;
+		_bits = 0;
+		return _short ? BMP_ERR_READ : BMP_OK;
+	}
+	int16_t  width(void) const { return _width; }
+	int16_t  height(void) const { return _height; }
+	uint8_t  depth(void) const { return _bpp; }
+	bool     bottomUp(void) const { return _bottomUp; }
+
+	// the next n pixels of the current row as 565.  a row must be read to its end before the next
+	// one starts.  returns fewer than n if the source runs dry
+	int16_t  read(uint16_t *dst, int16_t n)
+	{
+		int16_t done = 0;
+		if (_bpp < 8)
+		{
+			const uint8_t mask = (1 << _bpp) - 1;
+			for (; done < n; done++)
+			{
+				if (_bits == 0)
+				{
+					if (_head == _tail && !fill())
+						break;
+					_byte = _cache[_head++];
+					_bits = 8;
+				}
+				_bits -= _bpp;
+				*dst++ = _palette[(_byte >> _bits) & mask];
+			}
+		}
+		else
+		{
+			const uint8_t size = _bpp / 8;
+			while (done < n)
+			{
+				int16_t k = (_tail - _head) / size;
+				if (k == 0)
+				{
+					if (!fill())
+						break;
+					continue;
+				}
+				if (k > n - done)
+					k = n - done;
+				convert(_cache + _head, dst, k);
+				_head += k * size;
+				dst += k;
+				done += k;
+			}
+		}
+		_col += done;
+		if (_col == _width)          // row padding
+		{
+			_col = 0;
+			_bits = 0;
+			skip(_pad);
+		}
+		return done;
+	}
+
+	protected:
+	static uint16_t rgb(uint32_t bgr) { return ((bgr >> 8) & 0xF800) | ((bgr >> 5) & 0x07E0) | ((bgr >> 3) & 0x001F); }
+
+	void     convert(const uint8_t *p, uint16_t *dst, int16_t k) const
+	{
+		switch (_bpp)
+		{
+		case 8:
+			for (; k > 0; --k)
+				*dst++ = _palette[*p++];
+			break;
+		case 16:
+			for (; k > 0; --k, p += 2)
+			{
+				const uint16_t v = p[0] | (p[1] << 8);
+				*dst++ = _565 ? v : ((v & 0x7FE0) << 1) | ((v >> 4) & 0x0020) | (v & 0x001F);
+			}
+			break;
+		case 24:
+			for (; k > 0; --k, p += 3)
+				*dst++ = ((p[2] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[0] >> 3);
+			break;
+		case 32:
+			for (; k > 0; --k, p += 4)
+				*dst++ = ((p[2] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[0] >> 3);
+			break;
+		}
+	}
+
+	// keep what is left, top up the rest of the cache with one read
+	bool     fill(void)
+	{
+		const uint16_t left = _tail - _head;
+		memmove(_cache, _cache + _head, left);
+		_head = 0;
+		_tail = left + streamRead(_src, _cache + left, CACHE - left);
+		if (_tail == left)
+			_short = true;
+		return _tail > left;
+	}
+	uint32_t take(uint8_t bytes)     // little endian, at most 4 bytes
+	{
+		uint32_t v = 0;
+		if (bytes > 4)
+			bytes = 4;
+		for (uint8_t i = 0; i < bytes; i++)
+		{
+			if (_head == _tail && !fill())
+				return 0;
+			v |= (uint32_t)_cache[_head++] << (8 * i);
+		}
+		return v;
+	}
+	void     skip(uint32_t n)
+	{
+		while (n > 0)
+		{
+			if (_head == _tail && !fill())
+				return;
+			const uint16_t k = ((uint32_t)(_tail - _head) < n) ? _tail - _head : n;
+			_head += k;
+			n -= k;
+		}
+	}
+
+	Source  &_src;
+	uint8_t  _cache[CACHE];
+	uint16_t _head = 0, _tail = 0;
+	uint16_t _palette[256];
+	int16_t  _width = 0, _height = 0, _col = 0;
+	uint8_t  _bpp = 0, _pad = 0, _byte = 0, _bits = 0;
+	bool     _bottomUp = false, _565 = false, _short = false;
+};
+
+#endif
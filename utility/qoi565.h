@@ -0,0 +1,182 @@
+/*
+ * Q565: lossless compression of 565 images after QOI.  No Arduino dependencies: the host tools use it too.
+ *
+ * Header: "q565", width and height as 16-bit, high byte first.  Then one op per pixel or run:
+ *   00iiiiii  index: the colour in slot i of the 64 most recently seen (slot = (r*3 + g*5 + b*7) & 63)
+ *   01rrggbb  diff:  red, green, blue change by -2..1 (stored + 2)
+ *   10gggggg  luma:  green changes by -32..31 (+ 32), the next byte holds red and blue change minus
+ *                    half the green change, -8..7 (+ 8) in each nibble
+ *   11nnnnnn  run:   the previous colour n + 1 more times, n < 62
+ *   11111110  raw:   the colour in the next 2 bytes, high byte first
+ * Channel arithmetic wraps.  Decoding starts from black with every slot black.
+ */
+
+#ifndef QOI565_H_
+#define QOI565_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#endif
+
+enum { Q565_HEADER = 8, Q565_RAW = 0xFE, Q565_MAX_RUN = 62 };
+
+inline uint8_t q565Slot(uint16_t c) { return ((c >> 11) * 3 + ((c >> 5) & 0x3F) * 5 + (c & 0x1F) * 7) & 63; }
+
+// appends to a caller buffer.  overflow() is set instead of writing past size
+class Qoi565Encoder {
+
+	public:
+	Qoi565Encoder(uint8_t *out, size_t size, uint16_t w, uint16_t h) : _out(out), _size(size)
+	{
+		memset(_index, 0, sizeof(_index));
+		put('q'), put('5'), put('6'), put('5');
+		put(w >> 8), put(w), put(h >> 8), put(h);
+	}
+	void     push(uint16_t color)
+	{
+		if (color == _prev)
+		{
+			if (++_run == Q565_MAX_RUN)
+				flushRun();
+			return;
+		}
+		flushRun();
+		const uint8_t slot = q565Slot(color);
+		if (_index[slot] == color)
+			put(slot);
+		else
+		{
+			_index[slot] = color;
+			const int8_t dr = (((color >> 11) - (_prev >> 11) + 16) & 31) - 16;
+			const int8_t dg = ((((color >> 5) & 0x3F) - ((_prev >> 5) & 0x3F) + 32) & 63) - 32;
+			const int8_t db = (((color & 0x1F) - (_prev & 0x1F) + 16) & 31) - 16;
+			const int8_t hg = ((dg + 32) >> 1) - 16, rg = dr - hg, bg = db - hg;
+			if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+				put(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+			else if (rg >= -8 && rg <= 7 && bg >= -8 && bg <= 7)
+				put(0x80 | (dg + 32)), put(((rg + 8) << 4) | (bg + 8));
+			else
+				put(Q565_RAW), put(color >> 8), put(color);
+		}
+		_prev = color;
+	}
+	void     push(const uint16_t *block, int32_t n)
+	{
+		for (; n > 0; --n)
+			push(*block++);
+	}
+	size_t   finish(void)             // total bytes, 0 on overflow
+	{
+		flushRun();
+		return _overflow ? 0 : _len;
+	}
+	bool     overflow(void) const { return _overflow; }
+
+	protected:
+	void     put(uint8_t b)
+	{
+		if (_len < _size)
+			_out[_len++] = b;
+		else
+			_overflow = true;
+	}
+	void     flushRun(void)
+	{
+		if (_run)
+			put(0xC0 | (_run - 1));
+		_run = 0;
+	}
+
+	uint8_t *_out;
+	size_t   _size, _len = 0;
+	uint16_t _index[64];
+	uint16_t _prev = 0;
+	uint8_t  _run = 0;
+	bool     _overflow = false;
+};
+
+// reads from RAM, or from flash through pgm_read_byte.  state is the 64 slots and the current run
+class Qoi565Decoder {
+
+	public:
+	Qoi565Decoder(const uint8_t *src, bool progmem) : _src(src), _progmem(progmem) {}
+	bool     begin(void)              // check the header
+	{
+		if (fetch() != 'q' || fetch() != '5' || fetch() != '6' || fetch() != '5')
+			return false;
+		_width = fetch16();
+		_height = fetch16();
+		memset(_index, 0, sizeof(_index));
+		_color = 0;
+		_run = 0;
+		return true;
+	}
+	uint16_t width(void) const { return _width; }
+	uint16_t height(void) const { return _height; }
+
+	void     read(uint16_t *dst, int16_t n)   // decode n pixels
+	{
+		while (n > 0)
+		{
+			if (_run)
+			{
+				uint8_t k = (_run < n) ? _run : n;
+				_run -= k;
+				n -= k;
+				for (; k > 0; --k)
+					*dst++ = _color;
+				continue;
+			}
+			const uint8_t op = fetch();
+			if (op == Q565_RAW)
+				_color = fetch16();
+			else if (op < 0x40)
+			{
+				*dst++ = _color = _index[op];
+				n--;
+				continue;
+			}
+			else if (op < 0x80)
+				_color = shift(_color, ((op >> 4) & 3) - 2, ((op >> 2) & 3) - 2, (op & 3) - 2);
+			else if (op < 0xC0)
+			{
+				const int8_t dg = (op & 0x3F) - 32, hg = ((dg + 32) >> 1) - 16;
+				const uint8_t rb = fetch();
+				_color = shift(_color, (rb >> 4) - 8 + hg, dg, (rb & 0x0F) - 8 + hg);
+			}
+			else
+			{
+				_run = (op & 0x3F) + 1;
+				continue;
+			}
+			_index[q565Slot(_color)] = _color;
+			*dst++ = _color;
+			n--;
+		}
+	}
+
+	protected:
+	static uint16_t shift(uint16_t c, int8_t dr, int8_t dg, int8_t db)
+	{
+		return (((c >> 11) + dr) & 31) << 11 | ((((c >> 5) & 0x3F) + dg) & 63) << 5 | (((c & 0x1F) + db) & 31);
+	}
+	uint8_t  fetch(void) { return _progmem ? pgm_read_byte(_src++) : *_src++; }
+	uint16_t fetch16(void)
+	{
+		const uint8_t hi = fetch();
+		return (hi << 8) | fetch();
+	}
+
+	const uint8_t *_src;
+	bool     _progmem;
+	uint16_t _width = 0, _height = 0;
+	uint16_t _index[64];
+	uint16_t _color = 0;
+	uint8_t  _run = 0;
+};
+
+#endif
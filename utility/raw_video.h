@@ -0,0 +1,173 @@
+/*
+ * Playback of raw 565 frames from a streamRead() source.  No Arduino dependencies: the host tools use it too.
+ *
+ * The stream is frames of w x h pixels, 2 bytes each, little endian unless setFrame() says otherwise,
+ * with nothing between them.  setCrop() picks the part of each frame that is shown; the rest is
+ * skipped with streamSkip(), so seekable sources (SD File, std::istream) never read it.
+ * Every frame goes through one window, a row at a time through the caller's buffer (crop width
+ * pixels): each row is read with one call, then pushed.  Reading and pushing do not overlap, so a
+ * second row buffer would gain nothing.
+ * With a target frame rate play() waits for each frame's slot, and a frame that would start more
+ * than one period late is skipped instead of drawn.  Never two in a row: if a skip did not catch up
+ * (a Stream that cannot seek reads skipped frames too) the schedule restarts at the next frame.
+ * stats() has the frame rate and how much of the time the bus sat idle waiting for the source.
+ */
+
+#ifndef RAW_VIDEO_H_
+#define RAW_VIDEO_H_
+
+#include "stream_source.h"
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+inline uint32_t videoMicros(void) { return micros(); }
+#else
+#include <chrono>
+inline uint32_t videoMicros(void)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+template <class Source, class Display>
+class RawVideo {
+
+	public:
+	struct Stats {
+		uint32_t frames, dropped;
+		uint32_t readUs, pushUs, waitUs;    // time spent reading, pushing and waiting for a frame slot
+		uint32_t elapsedUs;
+		float    fps(void) const { return elapsedUs ? frames * 1e6f / elapsedUs : 0; }
+		uint8_t  busIdle(void) const { return (readUs + pushUs) ? (uint64_t)readUs * 100 / (readUs + pushUs) : 0; }  // percent
+	};
+
+	// buffer holds one row of the crop width
+	RawVideo(Display &tft, Source &src, uint16_t *buffer, int16_t w, int16_t h) : _tft(tft), _src(src), _buffer(buffer)
+	{
+		setFrame(w, h);
+		resetStats();
+	}
+	void     setFrame(int16_t w, int16_t h, bool bigEndian = false)
+	{
+		_w = w, _h = h, _bigEndian = bigEndian;
+		setCrop(0, 0, w, h);
+	}
+	void     setCrop(int16_t x, int16_t y, int16_t w, int16_t h)  // clipped to the frame
+	{
+		if (x < 0)
+			w += x, x = 0;
+		if (y < 0)
+			h += y, y = 0;
+		_cx = (x < _w) ? x : _w;
+		_cy = (y < _h) ? y : _h;
+		_cw = (w < 0) ? 0 : (w < _w - _cx) ? w : _w - _cx;
+		_ch = (h < 0) ? 0 : (h < _h - _cy) ? h : _h - _cy;
+	}
+	void     setPosition(int16_t x, int16_t y) { _x = x, _y = y; }
+	void     setFps(uint8_t fps)              // 0 plays as fast as the source allows.  restarts the stats
+	{
+		_period = fps ? 1000000UL / fps : 0;
+		_skipped = false;
+		resetStats();
+	}
+
+	// show or skip the next frame.  false at the end of the stream
+	bool     play(void)
+	{
+		uint32_t now = videoMicros();
+		if (!_started)
+		{
+			_due = _start = now;
+			_started = true;
+		}
+		if (_period)
+		{
+			const bool late = (int32_t)(now - _due) > (int32_t)_period;
+			if (late && !_skipped)
+			{
+				_due += _period;
+				_skipped = true;
+				if (!skip((uint32_t)_w * _h * 2))
+					return false;
+				_stats.dropped++;
+				_stats.elapsedUs = videoMicros() - _start;
+				return true;
+			}
+			if (late) //skipping did not catch up: start the schedule again from here
+				_due = now;
+			_skipped = false;
+			const uint32_t wait = now;
+			while ((int32_t)(now - _due) < 0)
+				now = videoMicros();
+			_stats.waitUs += now - wait;
+			_due += _period;
+		}
+		const bool ok = frame();
+		if (ok)
+			_stats.frames++;
+		_stats.elapsedUs = videoMicros() - _start;
+		return ok;
+	}
+
+	const Stats &stats(void) const { return _stats; }
+	void     resetStats(void)
+	{
+		_stats = Stats();
+		_started = false;
+	}
+
+	protected:
+	bool     frame(void)
+	{
+		const uint32_t row = (uint32_t)_w * 2;
+		if (_cw == 0 || _ch == 0) //nothing shows.  the last pixel is read, so the end of the stream is still noticed
+		{
+			uint8_t last[2];
+			return row * _h >= 2 && skip(row * _h - 2) && streamRead(_src, last, 2) == 2;
+		}
+		if (!skip(row * _cy))
+			return false;
+		_tft.setAddrWindow(_x, _y, _x + _cw - 1, _y + _ch - 1);
+		uint16_t *line = _buffer;
+		for (int16_t r = 0; r < _ch; r++)
+		{
+			if (!skip((uint32_t)_cx * 2))
+				return false;
+			uint32_t t = videoMicros();
+			const size_t bytes = (size_t)_cw * 2;
+			for (size_t got = 0, k; got < bytes; got += k)
+			{
+				k = streamRead(_src, (uint8_t *)line + got, bytes - got);
+				if (k == 0)
+					return false;
+			}
+			if (_bigEndian)
+				for (int16_t i = 0; i < _cw; i++)
+					line[i] = (line[i] << 8) | (line[i] >> 8);
+			const uint32_t t1 = videoMicros();
+			_stats.readUs += t1 - t;
+			_tft.pushColors(line, _cw, r == 0);
+			_stats.pushUs += videoMicros() - t1;
+			if (!skip((uint32_t)(_w - _cx - _cw) * 2))
+				return false;
+		}
+		return skip(row * (_h - _cy - _ch));
+	}
+	bool     skip(uint32_t n)
+	{
+		const uint32_t t = videoMicros();
+		const bool ok = streamSkip(_src, n);
+		_stats.readUs += videoMicros() - t;
+		return ok;
+	}
+
+	Display &_tft;
+	Source  &_src;
+	uint16_t *_buffer;
+	int16_t  _w, _h, _cx, _cy, _cw, _ch, _x = 0, _y = 0;
+	bool     _bigEndian = false, _started = false, _skipped = false;
+	uint32_t _period = 0, _due = 0, _start = 0;
+	Stats    _stats;
+};
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Run-length encoding of 565 pixel streams.  No Arduino dependencies: the host tools use it too.
+ *
+ * A packet starts with one byte n:
+ *   n & 0x80  run:     (n & 0x7F) + 1 copies of the colour in the next 2 bytes
+ *   else      literal: n + 1 colours follow, 2 bytes each
+ * Colours are stored high byte first.
+ */
+
+#ifndef RLE565_H_
+#define RLE565_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#endif
+
+// appends to a caller buffer.  overflow() is set instead of writing past size
+class Rle565Encoder {
+
+	public:
+	Rle565Encoder(uint8_t *out, size_t size) : _out(out), _size(size) {}
+	void     push(uint16_t color)
+	{
+		if (_run && color == _color && _run < 128)
+		{
+			_run++;
+			return;
+		}
+		flushRun();
+		_color = color;
+		_run = 1;
+	}
+	void     push(const uint16_t *block, int16_t n)
+	{
+		for (; n > 0; --n)
+			push(*block++);
+	}
+	size_t   finish(void)             // total bytes, 0 on overflow
+	{
+		flushRun();
+		return _overflow ? 0 : _len;
+	}
+	bool     overflow(void) const { return _overflow; }
+
+	protected:
+	void     put(uint8_t b)
+	{
+		if (_len < _size)
+			_out[_len++] = b;
+		else
+			_overflow = true;
+	}
+	void     flushRun(void)
+	{
+		if (_run >= 2)
+		{
+			_literal = 0;
+			put(0x80 | (_run - 1));
+		}
+		else if (_run == 1)
+		{
+			if (_literal == 0 || _literal == 128) //open a new literal packet
+			{
+				_literalAt = _len;
+				_literal = 0;
+				put(0);
+			}
+			if (_literalAt < _size)
+				_out[_literalAt] = _literal++;
+		}
+		else
+			return;
+		put(_color >> 8);
+		put(_color);
+		_run = 0;
+	}
+
+	uint8_t *_out;
+	size_t   _size, _len = 0, _literalAt = 0;
+	uint16_t _color = 0;
+	uint8_t  _run = 0;
+	uint8_t  _literal = 0;           // pixels in the open literal packet
+	bool     _overflow = false;
+};
+
+// reads from RAM, or from flash through pgm_read_byte
+class Rle565Decoder {
+
+	public:
+	Rle565Decoder(const uint8_t *src, bool progmem) : _src(src), _progmem(progmem) {}
+	int16_t  read(uint16_t *dst, int16_t n)   // decode n pixels
+	{
+		const int16_t total = n;
+		while (n > 0)
+		{
+			if (_left == 0)
+			{
+				const uint8_t h = fetch();
+				_isRun = h & 0x80;
+				_left = (h & 0x7F) + 1;
+				if (_isRun)
+					_color = fetch16();
+			}
+			uint8_t k = (_left < n) ? _left : n;
+			_left -= k;
+			n -= k;
+			if (_isRun)
+				for (; k > 0; --k)
+					*dst++ = _color;
+			else
+				for (; k > 0; --k)
+					*dst++ = fetch16();
+		}
+		return total;
+	}
+	const uint8_t *position(void) const { return _src; }
+
+	protected:
+	uint8_t  fetch(void) { return _progmem ? pgm_read_byte(_src++) : *_src++; }
+	uint16_t fetch16(void)
+	{
+		const uint8_t hi = fetch();
+		return (hi << 8) | fetch();
+	}
+
+	const uint8_t *_src;
+	bool     _progmem;
+	bool     _isRun = false;
+	uint8_t  _left = 0;
+	uint16_t _color = 0;
+};
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * Byte sources for the streaming decoders.  No Arduino dependencies: the host tools use it too.
+ *
+ * streamRead() reads up to n bytes from anything with readBytes() (Arduino Stream, SD File)
+ * or read() / gcount() (std::istream) and returns how many it got.
+ * streamSkip() seeks when the source can (seekg(), or seek() and position() like SD File)
+ * and reads into a scratch buffer otherwise.  false if the source ran out.
+ */
+
+#ifndef STREAM_SOURCE_H_
+#define STREAM_SOURCE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+template <class S>
+inline auto streamRead(S &s, uint8_t *buf, size_t n) -> decltype(s.readBytes((char *)buf, n), size_t())
+{
+	return s.readBytes((char *)buf, n);
+}
+
+template <class S>
+inline auto streamRead(S &s, uint8_t *buf, size_t n) -> decltype(s.gcount(), size_t())
+{
+	s.read((char *)buf, n);
+	return s.gcount();
+}
+
+template <class S>
+inline auto streamSkip(S &s, uint32_t n, int) -> decltype(s.seekg(0, s.cur), bool())
+{
+	return bool(s.seekg(n, s.cur));
+}
+
+template <class S>
+inline auto streamSkip(S &s, uint32_t n, int) -> decltype(s.seek(s.position()), bool())
+{
+	return s.seek(s.position() + n);
+}
+
+template <class S>
+inline bool streamSkip(S &s, uint32_t n, long)
+{
+	uint8_t scratch[32];
+	while (n > 0)
+	{
+		const size_t k = streamRead(s, scratch, (n < sizeof(scratch)) ? n : sizeof(scratch));
+		if (k == 0)
+			return false;
+		n -= k;
+	}
+	return true;
+}
+
+template <class S>
+inline bool streamSkip(S &s, uint32_t n)
+{
+	return n == 0 || streamSkip(s, n, 0);
+}
+
+#endif